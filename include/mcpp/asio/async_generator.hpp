@@ -0,0 +1,205 @@
+// Copyright Mika Fischer 2022.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <mcpp/asio/awaitable_utils.hpp>
+#include <mcpp/asio/config.hpp>
+
+#if MCPP_ASIO_USE_BOOST
+#include <boost/asio/any_io_executor.hpp>
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/experimental/concurrent_channel.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#else
+#include <asio/any_io_executor.hpp>
+#include <asio/awaitable.hpp>
+#include <asio/co_spawn.hpp>
+#include <asio/experimental/concurrent_channel.hpp>
+#include <asio/use_awaitable.hpp>
+#endif
+
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace mcpp::asio {
+namespace detail {
+
+template <typename T, typename E>
+struct generator_state {
+    // An empty optional marks the end of the stream.
+    // The channel is locked, because producer and consumer can run on different threads. error_ is written by the
+    // producer before it sends the end marker, finished_ is only used by the consumer.
+    using channel_type = ::MCPP_ASIO_NAMESPACE::experimental::basic_concurrent_channel<
+        E, ::MCPP_ASIO_NAMESPACE::experimental::channel_traits<>, void(error_code, std::optional<T>)>;
+
+    channel_type channel_;
+    std::exception_ptr error_;
+    bool finished_ = false;
+
+    generator_state(const E &executor, std::size_t buffer_size) : channel_(executor, buffer_size) {}
+};
+
+} // namespace detail
+
+// Passed to the producer of an async_generator, co_await yield(value) suspends the producer until the value has been
+// taken by the consumer (or buffered, if the generator has a buffer).
+template <typename T, typename E = ::MCPP_ASIO_NAMESPACE::any_io_executor>
+class async_yield {
+  public:
+    explicit async_yield(std::shared_ptr<detail::generator_state<T, E>> state) : state_(std::move(state)) {}
+
+    auto operator()(T value) const -> detail::awaitable<void, E> {
+        return state_->channel_.async_send(error_code{}, std::optional<T>(std::move(value)),
+                                           ::MCPP_ASIO_NAMESPACE::use_awaitable_t<E>{});
+    }
+
+  private:
+    std::shared_ptr<detail::generator_state<T, E>> state_;
+};
+
+// Stream of values produced by a coroutine running on E.
+// Values are handed over through a thread-safe channel, so the producer runs at most buffer_size values ahead of the
+// consumer, and producer and consumer may run on different threads, e.g. of a multi-threaded io_context.
+// The generator object itself is for a single consumer and must not be used from several threads at once.
+// Destroying the generator cancels the producer at its next yield.
+template <typename T, typename E = ::MCPP_ASIO_NAMESPACE::any_io_executor>
+class async_generator {
+    static_assert(!std::is_void_v<T> && !std::is_reference_v<T>);
+
+  public:
+    using value_type = T;
+    using executor_type = E;
+
+    explicit async_generator(std::shared_ptr<detail::generator_state<T, E>> state) : state_(std::move(state)) {}
+
+    async_generator(async_generator &&) noexcept = default;
+    auto operator=(async_generator &&other) noexcept -> async_generator & {
+        if (this != &other) {
+            close();
+            state_ = std::move(other.state_);
+        }
+        return *this;
+    }
+
+    async_generator(const async_generator &) = delete;
+    auto operator=(const async_generator &) -> async_generator & = delete;
+
+    ~async_generator() { close(); }
+
+    [[nodiscard]] auto get_executor() const -> executor_type { return state_->channel_.get_executor(); }
+
+    // Next value, or std::nullopt once the producer has finished.
+    // If the producer failed, its exception is rethrown instead.
+    auto next() -> detail::awaitable<std::optional<T>, E> {
+        auto state = state_;
+        if (!state->finished_) {
+            auto value = co_await state->channel_.async_receive(::MCPP_ASIO_NAMESPACE::use_awaitable_t<E>{});
+            if (value) {
+                co_return value;
+            }
+            state->finished_ = true;
+        }
+        if (state->error_) {
+            std::rethrow_exception(state->error_);
+        }
+        co_return std::nullopt;
+    }
+
+    // Waits for the next value like next(), then also takes up to n - 1 values that are available without suspending.
+    // An empty result means that the producer has finished.
+    // With a buffer, this drains the values the producer has run ahead with a single resumption of the consumer.
+    auto next_n(std::size_t n) -> detail::awaitable<std::vector<T>, E> {
+        auto state = state_;
+        auto result = std::vector<T>();
+        if (n == 0) {
+            co_return result;
+        }
+        auto first = co_await next();
+        if (!first) {
+            co_return result;
+        }
+        result.reserve(n);
+        result.push_back(std::move(*first));
+        auto stop = false;
+        while (!stop && result.size() < n && state->channel_.try_receive([&](error_code ec, auto &&...value) {
+            if constexpr (sizeof...(value) == 1) {
+                if (!ec && (value.has_value() && ...)) {
+                    result.push_back(std::move(*value)...);
+                    return;
+                }
+                state->finished_ = !ec;
+            }
+            stop = true;
+        })) {
+        }
+        co_return result;
+    }
+
+  private:
+    void close() {
+        if (state_) {
+            state_->channel_.close();
+            state_->channel_.cancel();
+            state_.reset();
+        }
+    }
+
+    std::shared_ptr<detail::generator_state<T, E>> state_;
+};
+
+// Starts producer(async_yield<T, E>) -> awaitable<void, E> on executor and returns the generator for its values.
+template <typename T, typename E, typename F>
+auto make_async_generator(const E &executor, F &&producer, std::size_t buffer_size = 0) -> async_generator<T, E> {
+    auto state = std::make_shared<detail::generator_state<T, E>>(executor, buffer_size);
+    ::MCPP_ASIO_NAMESPACE::co_spawn(
+        executor,
+        [producer = std::forward<F>(producer), yield = async_yield<T, E>(state)]() mutable {
+            return std::invoke(producer, yield);
+        },
+        [state](std::exception_ptr error) {
+            state->error_ = error;
+            state->channel_.async_send(error_code{}, std::optional<T>(), [state](error_code /*ec*/) {});
+        });
+    return async_generator<T, E>(std::move(state));
+}
+
+namespace detail {
+
+template <size_t I, typename V, typename T, typename E>
+auto pump_into(async_generator<T, E> &generator, async_yield<V, E> yield) -> awaitable<void, E> {
+    while (auto value = co_await generator.next()) {
+        co_await yield(V(std::in_place_index<I>, std::move(*value)));
+    }
+}
+
+} // namespace detail
+
+// Interleaves the values of several generators in the order in which they are produced.
+// The first exception wins and cancels the other generators, like in all().
+template <typename E, typename... Ts>
+auto merge(async_generator<Ts, E>... generators) -> async_generator<std::variant<Ts...>, E> {
+    static_assert(sizeof...(Ts) > 0);
+    using value_type = std::variant<Ts...>;
+    auto executor = std::get<0>(std::tie(generators...)).get_executor();
+    return make_async_generator<value_type>(
+        executor, [... generators = std::move(generators)](async_yield<value_type, E> yield) mutable
+                  -> detail::awaitable<void, E> {
+            co_await [&]<size_t... Is>(std::index_sequence<Is...>) {
+                return all(detail::pump_into<Is>(generators, yield)...);
+            }
+            (std::index_sequence_for<Ts...>{});
+        });
+}
+
+} // namespace mcpp::asio
@@ -16,6 +16,12 @@
 #include <asio/detail/handler_cont_helpers.hpp>
 #endif
 
+#if MCPP_ASIO_ENABLE_TRACING
+#include <mcpp/asio/tracing.hpp>
+#endif
+
+#include <cstddef>
+#include <tuple>
 #include <type_traits>
 #include <utility>
 
@@ -29,10 +35,55 @@ concept wrapped_handler_impl = requires(const T &impl) {
     std::is_object_v<T>;
 };
 
+#if MCPP_ASIO_ENABLE_TRACING
+// Span of a pending handler, ended when the handler is invoked or, if it is abandoned, destroyed.
+// A copy of a handler is not traced, the span stays with the original.
+struct handler_span {
+    tracing::span_id id = 0;
+    const char *name = nullptr;
+
+    handler_span() = default;
+    handler_span(const handler_span &other) noexcept : name(other.name) {}
+    handler_span(handler_span &&other) noexcept : id(std::exchange(other.id, 0)), name(other.name) {}
+    auto operator=(const handler_span &other) -> handler_span & {
+        if (this != &other) {
+            end();
+            name = other.name;
+        }
+        return *this;
+    }
+    auto operator=(handler_span &&other) -> handler_span & {
+        if (this != &other) {
+            end();
+            id = std::exchange(other.id, 0);
+            name = other.name;
+        }
+        return *this;
+    }
+    ~handler_span() { end(); }
+
+    void end() {
+        if (id != 0) {
+            tracing::end_span(std::exchange(id, 0), name);
+        }
+    }
+
+    // Ends the span and makes it current while the inner handler runs
+    [[nodiscard]] auto complete() -> tracing::current_span_scope {
+        auto completed = id;
+        end();
+        return tracing::current_span_scope(completed != 0 ? completed : tracing::current());
+    }
+};
+#endif
+
 template <typename Handler, wrapped_handler_impl Implementation>
 struct wrapped_handler {
     Handler inner_handler_;
     [[no_unique_address]] Implementation implementation_;
+#if MCPP_ASIO_ENABLE_TRACING
+    handler_span span_;
+#endif
 
     template <decays_to<Handler> H, typename TokenImpl>
         requires(std::is_default_constructible_v<Implementation> && !std::is_constructible_v<Implementation, TokenImpl>)
@@ -47,12 +98,20 @@ struct wrapped_handler {
     template <typename... Args>
         requires(std::is_invocable_v<Implementation &&, Handler &, Args &&...>)
     auto operator()(Args &&...args) && {
+#if MCPP_ASIO_ENABLE_TRACING
+        auto scope = span_.complete();
+#endif
         return std::move(implementation_)(inner_handler_, std::forward<Args>(args)...);
     }
 
     template <typename... Args>
         requires(!std::is_invocable_v<Implementation &&, Handler &, Args &&...>)
-    auto operator()(Args &&...args) && { return std::move(inner_handler_)(std::forward<Args>(args)...); }
+    auto operator()(Args &&...args) && {
+#if MCPP_ASIO_ENABLE_TRACING
+        auto scope = span_.complete();
+#endif
+        return std::move(inner_handler_)(std::forward<Args>(args)...);
+    }
 };
 
 template <typename Handler, wrapped_handler_impl Implementation>
@@ -65,6 +124,20 @@ concept wrapped_token_impl = requires(const T &impl) {
     requires(wrapped_handler_impl<typename T::handler_impl>);
 };
 
+template <typename Impl>
+struct trace_name {
+    static constexpr const char *value = "wrapped_token";
+};
+
+template <typename Impl>
+    requires requires { Impl::trace_name; }
+struct trace_name<Impl> {
+    static constexpr const char *value = Impl::trace_name;
+};
+
+template <typename Impl>
+inline constexpr const char *trace_name_v = trace_name<Impl>::value;
+
 template <typename Signature, typename Impl>
 struct transform_signature_impl {
     using type = Signature;
@@ -111,15 +184,156 @@ struct wrapped_token {
     }
 };
 
+template <typename Signature, typename... Impls>
+struct transform_signature_fold {
+    using type = Signature;
+};
+
+template <typename Signature, typename Impl, typename... Impls>
+struct transform_signature_fold<Signature, Impl, Impls...>
+    : transform_signature_fold<transform_signature_t<Signature, Impl>, Impls...> {};
+
+template <typename HandlerImpl, typename TokenImpl>
+inline auto make_handler_impl(TokenImpl &&token_impl) -> HandlerImpl {
+    if constexpr (std::is_constructible_v<HandlerImpl, TokenImpl>) {
+        return HandlerImpl(std::forward<TokenImpl>(token_impl));
+    } else {
+        return HandlerImpl();
+    }
+}
+
+// Implementations whose handler_impl either never calls the handler, or only calls it before returning from its own
+// operator(), can declare `static constexpr bool invokes_handler_inline = true;`.
+// Only those are fused with other layers, all others keep getting the real inner handler, which they may move away.
+template <typename Impl>
+concept fusable_impl = requires {
+    requires Impl::invokes_handler_inline;
+};
+
+template <std::size_t I, typename Handler, typename HandlerImpls>
+struct fused_stage;
+
+// Stands in for the handler of the I-th implementation of a fused handler, calling the remaining ones in turn.
+// It refers into the wrapped_handler, which is why only implementations that call it inline can be fused.
+// The associated executor, allocator and cancellation slot are those of the real handler.
+template <std::size_t I, typename Handler, typename... HandlerImpls>
+struct fused_stage<I, Handler, std::tuple<HandlerImpls...>> {
+    std::tuple<HandlerImpls...> &implementations_;
+    Handler &handler_;
+
+    template <typename... Args>
+    auto operator()(Args &&...args) && {
+        if constexpr (I == sizeof...(HandlerImpls)) {
+            return std::move(handler_)(std::forward<Args>(args)...);
+        } else {
+            using implementation = std::tuple_element_t<I, std::tuple<HandlerImpls...>>;
+            using next_stage = fused_stage<I + 1, Handler, std::tuple<HandlerImpls...>>;
+            auto next = next_stage{implementations_, handler_};
+            if constexpr (std::is_invocable_v<implementation &&, next_stage &, Args &&...>) {
+                return std::move(std::get<I>(implementations_))(next, std::forward<Args>(args)...);
+            } else {
+                return std::move(next)(std::forward<Args>(args)...);
+            }
+        }
+    }
+};
+
+// Several token implementations applied by a single wrapped_token, outermost first.
+// The signature is transformed by all of them in turn and their handler_impls are stored in one handler.
+template <fusable_impl... Impls>
+struct fused_impl {
+    static constexpr const char *trace_name = trace_name_v<std::tuple_element_t<0, std::tuple<Impls...>>>;
+    static constexpr bool invokes_handler_inline = true;
+
+    std::tuple<Impls...> implementations_;
+
+    explicit fused_impl(std::tuple<Impls...> &&implementations) : implementations_(std::move(implementations)) {}
+
+    template <typename Signature>
+    using transform_signature = typename transform_signature_fold<Signature, Impls...>::type;
+
+    struct handler_impl {
+        using implementations_type = std::tuple<typename Impls::handler_impl...>;
+
+        implementations_type implementations_;
+
+        explicit handler_impl(fused_impl &&token_impl)
+            : implementations_(std::apply(
+                  [](Impls &&...impls) {
+                      return std::tuple(make_handler_impl<typename Impls::handler_impl>(std::move(impls))...);
+                  },
+                  std::move(token_impl.implementations_))) {}
+
+        template <typename Handler, typename... Args>
+        auto operator()(Handler &handler, Args &&...args) && {
+            return fused_stage<0, Handler, implementations_type>{implementations_, handler}(
+                std::forward<Args>(args)...);
+        }
+    };
+};
+
+template <typename T>
+struct is_fused_impl : std::false_type {};
+
+template <typename... Impls>
+struct is_fused_impl<fused_impl<Impls...>> : std::true_type {};
+
+template <typename T>
+struct is_wrapped_token : std::false_type {};
+
+template <typename Impl, typename CT>
+struct is_wrapped_token<wrapped_token<Impl, CT>> : std::true_type {};
+
+template <typename Impl>
+inline auto fused_implementations(Impl &&impl) {
+    if constexpr (is_fused_impl<std::decay_t<Impl>>::value) {
+        return std::forward<Impl>(impl).implementations_;
+    } else {
+        return std::tuple<std::decay_t<Impl>>(std::forward<Impl>(impl));
+    }
+}
+
+template <typename... Impls>
+inline auto make_fused_impl(std::tuple<Impls...> &&implementations) {
+    return fused_impl<Impls...>(std::move(implementations));
+}
+
+template <typename T>
+inline constexpr bool is_fusable_token_v = false;
+
+template <typename Impl, typename CT>
+inline constexpr bool is_fusable_token_v<wrapped_token<Impl, CT>> = fusable_impl<Impl>;
+
+// Wrapping a wrapped_token does not nest, the implementations are fused into a single layer instead.
+// This way stacking adapters yields a single initiation lambda and a single wrapped_handler.
 template <wrapped_token_impl Impl, typename CT, typename... Ts>
 inline auto make_wrapped_token(CT &&token, Ts &&...args) {
-    return wrapped_token<Impl, std::decay_t<CT>>(std::forward<CT>(token), std::forward<Ts>(args)...);
+    if constexpr (fusable_impl<Impl> && is_fusable_token_v<std::decay_t<CT>>) {
+        auto implementation = make_fused_impl(std::tuple_cat(
+            fused_implementations(Impl(std::forward<Ts>(args)...)),
+            fused_implementations(std::forward<CT>(token).implementation_)));
+        using inner_token = std::decay_t<decltype(token.inner_token_)>;
+        return wrapped_token<decltype(implementation), inner_token>(std::forward<CT>(token).inner_token_,
+                                                                    std::move(implementation));
+    } else {
+        return wrapped_token<Impl, std::decay_t<CT>>(std::forward<CT>(token), std::forward<Ts>(args)...);
+    }
 }
 
 } // namespace mcpp::asio::detail
 
 namespace MCPP_ASIO_NAMESPACE {
 
+template <template <class, class> class Associator, std::size_t I, class Handler, class HandlerImpls, class Default>
+struct associator<Associator, mcpp::asio::detail::fused_stage<I, Handler, HandlerImpls>, Default>
+    : Associator<Handler, Default> {
+    using base = Associator<Handler, Default>;
+    static auto get(const mcpp::asio::detail::fused_stage<I, Handler, HandlerImpls> &stage,
+                    const Default &d = {}) noexcept {
+        return base::get(stage.handler_, d);
+    }
+};
+
 template <template <class, class> class Associator, class Handler, class Implementation, class Default>
 struct associator<Associator, mcpp::asio::detail::wrapped_handler<Handler, Implementation>, Default>
     : Associator<Handler, Default> {
@@ -141,8 +355,15 @@ struct async_result<mcpp::asio::detail::wrapped_token<Impl, CT>, Ss...>
              token_impl = std::move(token.implementation_)]<class H, class... Us>(H &&handler, Us &&...args2) mutable {
                 using handler_impl = typename Impl::handler_impl;
                 using wrapped_handler = mcpp::asio::detail::wrapped_handler<std::decay_t<H>, handler_impl>;
+#if MCPP_ASIO_ENABLE_TRACING
+                auto traced = wrapped_handler(std::forward<H>(handler), std::move(token_impl));
+                traced.span_.name = mcpp::asio::detail::trace_name_v<Impl>;
+                traced.span_.id = mcpp::asio::tracing::begin_span(traced.span_.name);
+                return std::move(init)(std::move(traced), std::forward<Us>(args2)...);
+#else
                 return std::move(init)(wrapped_handler(std::forward<H>(handler), std::move(token_impl)),
                                        std::forward<Us>(args2)...);
+#endif
             },
             std::move(token.inner_token_), std::forward<Ts>(args)...);
     }
@@ -22,12 +22,35 @@
 #include <asio/use_awaitable.hpp>
 #endif
 
+#if MCPP_ASIO_USE_BOOST
+#include <boost/asio/async_result.hpp>
+#include <boost/asio/bind_cancellation_slot.hpp>
+#include <boost/asio/cancellation_signal.hpp>
+#include <boost/asio/dispatch.hpp>
+#else
+#include <asio/async_result.hpp>
+#include <asio/bind_cancellation_slot.hpp>
+#include <asio/cancellation_signal.hpp>
+#include <asio/dispatch.hpp>
+#endif
+
+#include <mcpp/asio/erased_handler.hpp>
+
+#if MCPP_ASIO_ENABLE_TRACING
+#include <mcpp/asio/tracing.hpp>
+#endif
+
+#include <atomic>
+#include <cstddef>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <stdexcept>
 #include <tuple>
 #include <type_traits>
 #include <utility>
 #include <variant>
+#include <vector>
 
 namespace mcpp::asio {
 namespace detail {
@@ -121,6 +144,28 @@ struct awaitable_traits {
 template <typename T, typename E>
 using awaitable = ::MCPP_ASIO_NAMESPACE::awaitable<T, E>;
 
+#if MCPP_ASIO_ENABLE_TRACING
+template <typename T, typename E>
+auto trace_child(awaitable<T, E> child, const char *name, tracing::span_id parent, std::int32_t index)
+    -> awaitable<T, E> {
+    auto span = tracing::scoped_span(name, parent, index);
+    co_return co_await std::move(child);
+}
+
+// Like make_parallel_group(co_spawn(executor, awaitables, deferred)...), but every child is tagged with its index
+template <typename Executor, typename E, typename... Ts>
+auto make_traced_group(const Executor &executor, const char *name, tracing::span_id parent,
+                       awaitable<Ts, E>... awaitables) {
+    using ::MCPP_ASIO_NAMESPACE::experimental::deferred, ::MCPP_ASIO_NAMESPACE::experimental::make_parallel_group;
+    return [&]<size_t... Is>(std::index_sequence<Is...>) {
+        return make_parallel_group(
+            co_spawn(executor, trace_child(std::move(awaitables), name, parent, static_cast<std::int32_t>(Is)),
+                     deferred)...);
+    }
+    (std::index_sequence_for<Ts...>{});
+}
+#endif
+
 } // namespace detail
 
 // First exception or result wins.
@@ -133,7 +178,12 @@ auto race(detail::awaitable<Ts, E>... awaitables)
     namespace this_coro = ::MCPP_ASIO_NAMESPACE::this_coro;
     using traits = detail::awaitable_traits<Ts...>;
 
+#if MCPP_ASIO_ENABLE_TRACING
+    auto span = tracing::scoped_span("race");
+    auto group = detail::make_traced_group(co_await this_coro::executor, "race", span.id(), std::move(awaitables)...);
+#else
     auto group = make_parallel_group(co_spawn(co_await this_coro::executor, std::move(awaitables), deferred)...);
+#endif
     auto results = co_await group.async_wait(wait_for_one(), use_awaitable);
     auto awaitable_idx = std::get<0>(results)[0];
     co_return detail::invoke_with_idx<sizeof...(Ts)>(awaitable_idx, [&results](auto I) {
@@ -153,7 +203,12 @@ auto all(detail::awaitable<Ts, E>... awaitables) -> detail::awaitable<std::tuple
     namespace this_coro = ::MCPP_ASIO_NAMESPACE::this_coro;
     using traits = detail::awaitable_traits<Ts...>;
 
+#if MCPP_ASIO_ENABLE_TRACING
+    auto span = tracing::scoped_span("all");
+    auto group = detail::make_traced_group(co_await this_coro::executor, "all", span.id(), std::move(awaitables)...);
+#else
     auto group = make_parallel_group(co_spawn(co_await this_coro::executor, std::move(awaitables), deferred)...);
+#endif
     auto results = co_await group.async_wait(wait_for_one_error(), use_awaitable);
     for (auto awaitable_idx : std::get<0>(results)) {
         if (auto error = detail::invoke_with_idx<sizeof...(Ts)>(awaitable_idx, [&results](auto I) {
@@ -177,7 +232,13 @@ auto all_settled(detail::awaitable<Ts, E>... awaitables)
     namespace this_coro = ::MCPP_ASIO_NAMESPACE::this_coro;
     using traits = detail::awaitable_traits<Ts...>;
 
+#if MCPP_ASIO_ENABLE_TRACING
+    auto span = tracing::scoped_span("all_settled");
+    auto group =
+        detail::make_traced_group(co_await this_coro::executor, "all_settled", span.id(), std::move(awaitables)...);
+#else
     auto group = make_parallel_group(co_spawn(co_await this_coro::executor, std::move(awaitables), deferred)...);
+#endif
     auto results = co_await group.async_wait(wait_for_all(), use_awaitable);
     co_return [&results]<size_t... Is>(std::index_sequence<Is...> is) {
         return std::tuple(traits::template get_group_result_or_error<Is>(results)...);
@@ -185,4 +246,175 @@ auto all_settled(detail::awaitable<Ts, E>... awaitables)
     (std::index_sequence_for<Ts...>{});
 }
 
+namespace detail {
+
+// Cancels the remaining operations of a parallel group once k have succeeded or more than n - k have failed
+class wait_for_quorum {
+  public:
+    wait_for_quorum(size_t k, size_t n, std::atomic<size_t> &successes, std::atomic<size_t> &failures)
+        : k_(k), n_(n), successes_(&successes), failures_(&failures) {}
+
+    template <typename... Args>
+    auto operator()(const std::exception_ptr &error, Args &&.../*args*/) const
+        -> ::MCPP_ASIO_NAMESPACE::cancellation_type_t {
+        if (error ? failures_->fetch_add(1) + 1 == n_ - k_ + 1 : successes_->fetch_add(1) + 1 == k_) {
+            return ::MCPP_ASIO_NAMESPACE::cancellation_type::all;
+        }
+        return ::MCPP_ASIO_NAMESPACE::cancellation_type::none;
+    }
+
+  private:
+    size_t k_;
+    size_t n_;
+    std::atomic<size_t> *successes_;
+    std::atomic<size_t> *failures_;
+};
+
+// Shared between the children of a ranged quorum and the coroutine waiting for them
+template <typename T, typename E>
+struct quorum_state {
+    std::mutex mutex_;
+    size_t k_;
+    size_t failures_ = 0;
+    size_t pending_;
+    bool decided_ = false;
+    std::vector<std::pair<size_t, to_variant_type_t<T>>> results_;
+    std::exception_ptr first_error_;
+    std::vector<::MCPP_ASIO_NAMESPACE::cancellation_signal> signals_;
+    E executor_;
+    ::MCPP_ASIO_NAMESPACE::cancellation_slot waiter_slot_;
+    erased_handler<void(), E> waiter_;
+
+    quorum_state(size_t k, size_t n, const E &executor) : k_(k), pending_(n), signals_(n), executor_(executor) {
+        results_.reserve(k);
+    }
+
+    // Children that have already completed are no longer connected to their signal
+    void cancel_children(::MCPP_ASIO_NAMESPACE::cancellation_type_t type) {
+        for (auto &signal : signals_) {
+            signal.emit(type);
+        }
+    }
+
+    template <typename... Args>
+    void complete(size_t idx, const std::exception_ptr &error, Args &&...args) {
+        auto lock = std::unique_lock(mutex_);
+        auto decided_now = false;
+        if (error) {
+            if (!first_error_) {
+                first_error_ = error;
+            }
+            decided_now = ++failures_ == signals_.size() - k_ + 1;
+        } else if (results_.size() < k_) {
+            results_.emplace_back(idx, to_variant_type_t<T>(std::forward<Args>(args)...));
+            decided_now = results_.size() == k_;
+        }
+        decided_now = decided_now && !std::exchange(decided_, true);
+        auto done = --pending_ == 0;
+        lock.unlock();
+
+        if (decided_now) {
+            cancel_children(::MCPP_ASIO_NAMESPACE::cancellation_type::all);
+        }
+        if (done) {
+            if (waiter_slot_.is_connected()) {
+                waiter_slot_.clear();
+            }
+            ::MCPP_ASIO_NAMESPACE::dispatch(executor_, std::move(waiter_));
+        }
+    }
+};
+
+} // namespace detail
+
+// The first k results win, in the order in which they arrived, together with the index of their awaitable.
+// Once k awaitables have succeeded, or too many have failed for that to be possible, the others are canceled.
+// In the latter case the first exception is rethrown, errors of canceled awaitables are ignored.
+template <typename E, typename... Ts>
+auto quorum(size_t k, detail::awaitable<Ts, E>... awaitables)
+    -> detail::awaitable<std::vector<std::pair<size_t, std::variant<detail::to_variant_type_t<Ts>...>>>, E> {
+    using ::MCPP_ASIO_NAMESPACE::experimental::deferred, ::MCPP_ASIO_NAMESPACE::use_awaitable,
+        ::MCPP_ASIO_NAMESPACE::experimental::make_parallel_group;
+    namespace this_coro = ::MCPP_ASIO_NAMESPACE::this_coro;
+    using traits = detail::awaitable_traits<Ts...>;
+    using result_type = std::variant<detail::to_variant_type_t<Ts>...>;
+
+    if (k > sizeof...(Ts)) {
+        throw std::invalid_argument("quorum: k is larger than the number of awaitables");
+    }
+    auto quorum_results = std::vector<std::pair<size_t, result_type>>();
+    if (k == 0) {
+        co_return quorum_results;
+    }
+
+#if MCPP_ASIO_ENABLE_TRACING
+    auto span = tracing::scoped_span("quorum");
+    auto group = detail::make_traced_group(co_await this_coro::executor, "quorum", span.id(), std::move(awaitables)...);
+#else
+    auto group = make_parallel_group(co_spawn(co_await this_coro::executor, std::move(awaitables), deferred)...);
+#endif
+    auto successes = std::atomic<size_t>(0);
+    auto failures = std::atomic<size_t>(0);
+    auto results = co_await group.async_wait(detail::wait_for_quorum(k, sizeof...(Ts), successes, failures),
+                                             use_awaitable);
+    quorum_results.reserve(k);
+    auto first_error = std::exception_ptr();
+    for (auto awaitable_idx : std::get<0>(results)) {
+        detail::invoke_with_idx<sizeof...(Ts)>(awaitable_idx, [&](auto I) {
+            if (auto error = std::get<traits::template group_result_idx_for_v<I>>(results)) {
+                if (!first_error) {
+                    first_error = error;
+                }
+            } else if (quorum_results.size() < k) {
+                quorum_results.emplace_back(
+                    I, result_type(std::in_place_index<I>, traits::template get_group_result<I>(results)));
+            }
+        });
+    }
+    if (quorum_results.size() < k) {
+        std::rethrow_exception(first_error);
+    }
+    co_return quorum_results;
+}
+
+// Like the variadic quorum, for any number of awaitables of the same type.
+template <typename T, typename E>
+auto quorum(size_t k, std::vector<detail::awaitable<T, E>> awaitables)
+    -> detail::awaitable<std::vector<std::pair<size_t, detail::to_variant_type_t<T>>>, E> {
+    namespace this_coro = ::MCPP_ASIO_NAMESPACE::this_coro;
+
+    if (k > awaitables.size()) {
+        throw std::invalid_argument("quorum: k is larger than the number of awaitables");
+    }
+    if (k == 0) {
+        co_return std::vector<std::pair<size_t, detail::to_variant_type_t<T>>>();
+    }
+
+    auto executor = co_await this_coro::executor;
+    auto state = std::make_shared<detail::quorum_state<T, E>>(k, awaitables.size(), executor);
+    auto token = ::MCPP_ASIO_NAMESPACE::use_awaitable_t<E>();
+    co_await ::MCPP_ASIO_NAMESPACE::async_initiate<decltype(token), void()>(
+        [&](auto handler) {
+            state->waiter_slot_ = ::MCPP_ASIO_NAMESPACE::get_associated_cancellation_slot(handler);
+            if (state->waiter_slot_.is_connected()) {
+                state->waiter_slot_.assign([state](::MCPP_ASIO_NAMESPACE::cancellation_type_t type) {
+                    state->cancel_children(type);
+                });
+            }
+            state->waiter_ = erased_handler<void(), E>(std::move(handler));
+            for (size_t i = 0; i < awaitables.size(); ++i) {
+                co_spawn(executor, std::move(awaitables[i]),
+                         ::MCPP_ASIO_NAMESPACE::bind_cancellation_slot(
+                             state->signals_[i].slot(), [state, i](std::exception_ptr error, auto &&...result) {
+                                 state->complete(i, error, std::forward<decltype(result)>(result)...);
+                             }));
+            }
+        },
+        token);
+    if (state->results_.size() < k) {
+        std::rethrow_exception(state->first_error_);
+    }
+    co_return std::move(state->results_);
+}
+
 } // namespace mcpp::asio
\ No newline at end of file
@@ -0,0 +1,576 @@
+// Copyright Mika Fischer 2022.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <mcpp/asio/async_op_utils.hpp>
+#include <mcpp/asio/config.hpp>
+#include <mcpp/asio/erased_handler.hpp>
+
+#if MCPP_ASIO_USE_BOOST
+#include <boost/asio/any_io_executor.hpp>
+#include <boost/asio/associated_cancellation_slot.hpp>
+#include <boost/asio/associated_executor.hpp>
+#include <boost/asio/async_result.hpp>
+#include <boost/asio/buffer.hpp>
+#include <boost/asio/cancellation_signal.hpp>
+#include <boost/asio/error.hpp>
+#include <boost/asio/execution/outstanding_work.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/prefer.hpp>
+#else
+#include <asio/any_io_executor.hpp>
+#include <asio/associated_cancellation_slot.hpp>
+#include <asio/associated_executor.hpp>
+#include <asio/async_result.hpp>
+#include <asio/buffer.hpp>
+#include <asio/cancellation_signal.hpp>
+#include <asio/error.hpp>
+#include <asio/execution/outstanding_work.hpp>
+#include <asio/post.hpp>
+#include <asio/prefer.hpp>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace mcpp::asio {
+
+class pooled_buffer;
+
+namespace detail {
+
+class buffer_pool_core;
+
+inline auto system_page_size() -> std::size_t {
+    static const auto page_size = [] {
+#if defined(_WIN32)
+        auto info = SYSTEM_INFO();
+        ::GetSystemInfo(&info);
+        return static_cast<std::size_t>(info.dwPageSize);
+#else
+        return static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+#endif
+    }();
+    return page_size;
+}
+
+// Slots of the cache of one thread. The owning thread pushes and pops slabs, other threads may reclaim them when the
+// global free list runs dry. Every slab is moved in and out with an atomic exchange, so exactly one side gets it.
+struct buffer_pool_cache_block {
+    explicit buffer_pool_cache_block(std::size_t size) : slots(size) {}
+
+    auto push(std::byte *slab) noexcept -> bool {
+        for (auto &slot : slots) {
+            auto *expected = static_cast<std::byte *>(nullptr);
+            if (slot.compare_exchange_strong(expected, slab)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    auto pop() noexcept -> std::byte * {
+        for (auto &slot : slots) {
+            if (slot.load() != nullptr) {
+                if (auto *slab = slot.exchange(nullptr)) {
+                    return slab;
+                }
+            }
+        }
+        return nullptr;
+    }
+
+    // Takes back a slab pushed earlier, fails if it has been reclaimed in the meantime
+    auto take(std::byte *slab) noexcept -> bool {
+        for (auto &slot : slots) {
+            auto *expected = slab;
+            if (slot.compare_exchange_strong(expected, nullptr)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Number of slabs currently cached, only a snapshot while the owner is active
+    [[nodiscard]] auto size() const noexcept -> std::size_t {
+        return static_cast<std::size_t>(std::count_if(slots.begin(), slots.end(), [](const auto &slot) {
+            return slot.load(std::memory_order_relaxed) != nullptr;
+        }));
+    }
+
+    std::vector<std::atomic<std::byte *>> slots;
+};
+
+// Slabs released on a thread are kept here for the next acquire on the same thread, up to the pool's cache size.
+// The cache is bound to the first pool acquired from on the thread and stays with it until that pool is gone. Other
+// pools used on the same thread bypass the cache instead of rebinding it, which would flush and reallocate each time.
+struct buffer_pool_thread_cache {
+    std::uint64_t pool_id = 0;
+    std::weak_ptr<buffer_pool_core> pool;
+    std::shared_ptr<buffer_pool_cache_block> block;
+
+    buffer_pool_thread_cache() = default;
+    buffer_pool_thread_cache(const buffer_pool_thread_cache &) = delete;
+    buffer_pool_thread_cache(buffer_pool_thread_cache &&) = delete;
+    auto operator=(const buffer_pool_thread_cache &) -> buffer_pool_thread_cache & = delete;
+    auto operator=(buffer_pool_thread_cache &&) -> buffer_pool_thread_cache & = delete;
+    ~buffer_pool_thread_cache() { flush(); }
+
+    inline void flush();
+
+    // Cache block of the pool, binding the cache to it if it is free. Null if it belongs to another pool.
+    inline auto bind(buffer_pool_core &core) -> buffer_pool_cache_block *;
+
+    // Cache block of the pool if it is already bound to it, never allocates
+    [[nodiscard]] inline auto find(const buffer_pool_core &core) const noexcept -> buffer_pool_cache_block *;
+};
+
+inline auto local_buffer_pool_cache() -> buffer_pool_thread_cache & {
+    thread_local auto cache = buffer_pool_thread_cache();
+    return cache;
+}
+
+} // namespace detail
+
+struct buffer_pool_stats {
+    std::size_t slab_size;
+    std::size_t capacity;
+    std::size_t in_use;
+    std::size_t high_water_mark;
+    std::size_t waiting;
+    std::size_t cached;
+};
+
+// Slab from a buffer_pool, returned to the pool on destruction.
+class pooled_buffer {
+  public:
+    pooled_buffer() noexcept = default;
+
+    pooled_buffer(pooled_buffer &&other) noexcept
+        : pool_(std::move(other.pool_)), slab_(std::exchange(other.slab_, nullptr)) {}
+
+    auto operator=(pooled_buffer &&other) noexcept -> pooled_buffer & {
+        if (this != &other) {
+            reset();
+            pool_ = std::move(other.pool_);
+            slab_ = std::exchange(other.slab_, nullptr);
+        }
+        return *this;
+    }
+
+    pooled_buffer(const pooled_buffer &) = delete;
+    auto operator=(const pooled_buffer &) -> pooled_buffer & = delete;
+
+    ~pooled_buffer() { reset(); }
+
+    [[nodiscard]] inline auto data() const noexcept -> ::MCPP_ASIO_NAMESPACE::mutable_buffer;
+    [[nodiscard]] inline auto size() const noexcept -> std::size_t;
+
+    explicit operator bool() const noexcept { return slab_ != nullptr; }
+
+    // Returns the slab to the pool early
+    inline void reset() noexcept;
+
+  private:
+    friend class detail::buffer_pool_core;
+
+    pooled_buffer(std::shared_ptr<detail::buffer_pool_core> pool, std::byte *slab) noexcept
+        : pool_(std::move(pool)), slab_(slab) {}
+
+    // Keeps the slab memory alive even if the buffer_pool is destroyed first
+    std::shared_ptr<detail::buffer_pool_core> pool_;
+    std::byte *slab_ = nullptr;
+};
+
+namespace detail {
+
+class buffer_pool_core : public std::enable_shared_from_this<buffer_pool_core> {
+  public:
+    using handler_type = erased_handler<void(error_code, pooled_buffer)>;
+
+    buffer_pool_core(::MCPP_ASIO_NAMESPACE::any_io_executor executor, std::size_t slab_size, std::size_t slab_count,
+                     std::size_t thread_cache_size)
+        : executor_(std::move(executor)), page_size_(system_page_size()), slab_size_(round_up(slab_size)),
+          slab_count_(slab_count), thread_cache_size_(thread_cache_size), id_(next_id()),
+          arena_(static_cast<std::byte *>(::operator new(slab_size_ * slab_count_, std::align_val_t(page_size_)))) {
+        free_.reserve(slab_count_);
+        for (std::size_t i = slab_count_; i > 0; --i) {
+            free_.push_back(arena_ + (i - 1) * slab_size_);
+        }
+    }
+
+    buffer_pool_core(const buffer_pool_core &) = delete;
+    buffer_pool_core(buffer_pool_core &&) = delete;
+    auto operator=(const buffer_pool_core &) -> buffer_pool_core & = delete;
+    auto operator=(buffer_pool_core &&) -> buffer_pool_core & = delete;
+
+    ~buffer_pool_core() { ::operator delete(arena_, std::align_val_t(page_size_)); }
+
+    [[nodiscard]] auto id() const noexcept -> std::uint64_t { return id_; }
+    [[nodiscard]] auto slab_size() const noexcept -> std::size_t { return slab_size_; }
+    [[nodiscard]] auto thread_cache_size() const noexcept -> std::size_t { return thread_cache_size_; }
+    [[nodiscard]] auto get_executor() const noexcept -> const ::MCPP_ASIO_NAMESPACE::any_io_executor & {
+        return executor_;
+    }
+
+    auto try_acquire() -> pooled_buffer {
+        auto *slab = take_cached();
+        if (slab == nullptr) {
+            auto lock = std::lock_guard(mutex_);
+            slab = take_free();
+            if (slab == nullptr) {
+                slab = reclaim_cached();
+            }
+        }
+        return slab != nullptr ? make_buffer(slab) : pooled_buffer();
+    }
+
+    void async_acquire(handler_type handler) {
+        if (auto *slab = take_cached()) {
+            complete(std::move(handler), error_code(), make_buffer(slab));
+            return;
+        }
+        auto lock = std::unique_lock(mutex_);
+        auto *slab = take_free();
+        if (slab == nullptr) {
+            auto waiter_id = next_waiter_id_++;
+            auto slot = ::MCPP_ASIO_NAMESPACE::get_associated_cancellation_slot(handler);
+            if (slot.is_connected()) {
+                slot.assign([pool = weak_from_this(), waiter_id](::MCPP_ASIO_NAMESPACE::cancellation_type_t /*type*/) {
+                    if (auto core = pool.lock()) {
+                        core->cancel(waiter_id);
+                    }
+                });
+            }
+            auto executor = ::MCPP_ASIO_NAMESPACE::get_associated_executor(handler, executor_);
+            auto work =
+                ::MCPP_ASIO_NAMESPACE::prefer(executor, ::MCPP_ASIO_NAMESPACE::execution::outstanding_work.tracked);
+            waiters_.push_back({waiter_id, std::move(handler), slot, std::move(work)});
+            // Publishing the waiter before looking at the thread caches pairs with release(): either the releasing
+            // thread sees the waiter and does not keep its slab, or the slab is found here
+            num_waiting_.store(waiters_.size());
+            if (auto *reclaimed = reclaim_cached()) {
+                hand_over(std::move(lock), reclaimed);
+            }
+            return;
+        }
+        lock.unlock();
+        complete(std::move(handler), error_code(), make_buffer(slab));
+    }
+
+    void release(std::byte *slab) noexcept {
+        in_use_.fetch_sub(1, std::memory_order_relaxed);
+        if (thread_cache_size_ > 0 && num_waiting_.load() == 0) {
+            // If a waiter was queued in the meantime, the slab is taken back for it, unless it already reclaimed it
+            if (auto *cache = local_buffer_pool_cache().find(*this);
+                cache != nullptr && cache->push(slab) && (num_waiting_.load() == 0 || !cache->take(slab))) {
+                return;
+            }
+        }
+        release_global(slab);
+    }
+
+    void release_global(std::byte *slab) noexcept { hand_over(std::unique_lock(mutex_), slab); }
+
+    void cancel(std::uint64_t waiter_id) {
+        auto lock = std::unique_lock(mutex_);
+        auto it = std::find_if(waiters_.begin(), waiters_.end(), [&](const auto &w) { return w.id == waiter_id; });
+        if (it == waiters_.end()) {
+            return;
+        }
+        auto canceled = std::move(*it);
+        waiters_.erase(it);
+        num_waiting_.store(waiters_.size());
+        lock.unlock();
+        complete(std::move(canceled.handler), ::MCPP_ASIO_NAMESPACE::error::operation_aborted, pooled_buffer());
+    }
+
+    // Fails all pending acquires, called when the buffer_pool is destroyed
+    void shutdown() {
+        auto lock = std::unique_lock(mutex_);
+        auto waiters = std::move(waiters_);
+        waiters_.clear();
+        num_waiting_.store(0);
+        lock.unlock();
+        for (auto &waiter : waiters) {
+            if (waiter.slot.is_connected()) {
+                waiter.slot.clear();
+            }
+            complete(std::move(waiter.handler), ::MCPP_ASIO_NAMESPACE::error::operation_aborted, pooled_buffer());
+        }
+    }
+
+    [[nodiscard]] auto stats() const -> buffer_pool_stats {
+        auto cached = std::size_t(0);
+        {
+            auto lock = std::lock_guard(mutex_);
+            for (const auto &block : caches_) {
+                cached += block->size();
+            }
+        }
+        return {slab_size_,
+                slab_count_,
+                in_use_.load(std::memory_order_relaxed),
+                high_water_mark_.load(std::memory_order_relaxed),
+                num_waiting_.load(std::memory_order_relaxed),
+                cached};
+    }
+
+    void register_cache(std::shared_ptr<buffer_pool_cache_block> block) {
+        auto lock = std::lock_guard(mutex_);
+        caches_.push_back(std::move(block));
+    }
+
+    // Called when a thread cache is flushed, its remaining slabs go back to the free list
+    void unregister_cache(const std::shared_ptr<buffer_pool_cache_block> &block) noexcept {
+        {
+            auto lock = std::lock_guard(mutex_);
+            std::erase(caches_, block);
+        }
+        while (auto *slab = block->pop()) {
+            release_global(slab);
+        }
+    }
+
+  private:
+    struct waiter {
+        std::uint64_t id;
+        handler_type handler;
+        ::MCPP_ASIO_NAMESPACE::cancellation_slot slot;
+        // Keeps the handler's executor from running out of work while the acquire is queued
+        ::MCPP_ASIO_NAMESPACE::any_io_executor work;
+    };
+
+    auto round_up(std::size_t size) const -> std::size_t {
+        return std::max<std::size_t>(1, (size + page_size_ - 1) / page_size_) * page_size_;
+    }
+
+    static auto next_id() -> std::uint64_t {
+        static auto counter = std::atomic<std::uint64_t>(1);
+        return counter.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    auto take_cached() -> std::byte * {
+        if (thread_cache_size_ == 0) {
+            return nullptr;
+        }
+        auto *cache = local_buffer_pool_cache().bind(*this);
+        return cache != nullptr ? cache->pop() : nullptr;
+    }
+
+    // Must be called with the mutex held
+    auto reclaim_cached() -> std::byte * {
+        for (const auto &block : caches_) {
+            if (auto *slab = block->pop()) {
+                return slab;
+            }
+        }
+        return nullptr;
+    }
+
+    // Gives the slab to the oldest waiter, or puts it on the free list
+    void hand_over(std::unique_lock<std::mutex> lock, std::byte *slab) noexcept {
+        if (waiters_.empty()) {
+            free_.push_back(slab);
+            return;
+        }
+        auto waiter = std::move(waiters_.front());
+        waiters_.pop_front();
+        num_waiting_.store(waiters_.size());
+        lock.unlock();
+        if (waiter.slot.is_connected()) {
+            waiter.slot.clear();
+        }
+        complete(std::move(waiter.handler), error_code(), make_buffer(slab));
+    }
+
+    // Must be called with the mutex held
+    auto take_free() -> std::byte * {
+        if (free_.empty()) {
+            return nullptr;
+        }
+        auto *slab = free_.back();
+        free_.pop_back();
+        return slab;
+    }
+
+    auto make_buffer(std::byte *slab) -> pooled_buffer {
+        auto in_use = in_use_.fetch_add(1, std::memory_order_relaxed) + 1;
+        auto high_water_mark = high_water_mark_.load(std::memory_order_relaxed);
+        while (in_use > high_water_mark &&
+               !high_water_mark_.compare_exchange_weak(high_water_mark, in_use, std::memory_order_relaxed)) {
+        }
+        return pooled_buffer(shared_from_this(), slab);
+    }
+
+    // Completes on the handler's executor, never from within the initiating function
+    void complete(handler_type handler, error_code ec, pooled_buffer buffer) {
+        auto executor = ::MCPP_ASIO_NAMESPACE::get_associated_executor(handler, executor_);
+        ::MCPP_ASIO_NAMESPACE::post(executor, [handler = std::move(handler), ec, buffer = std::move(buffer)]() mutable {
+            std::move(handler)(ec, std::move(buffer));
+        });
+    }
+
+    ::MCPP_ASIO_NAMESPACE::any_io_executor executor_;
+    std::size_t page_size_;
+    std::size_t slab_size_;
+    std::size_t slab_count_;
+    std::size_t thread_cache_size_;
+    std::uint64_t id_;
+    std::byte *arena_;
+
+    mutable std::mutex mutex_;
+    std::vector<std::byte *> free_;
+    std::deque<waiter> waiters_;
+    std::vector<std::shared_ptr<buffer_pool_cache_block>> caches_;
+    std::uint64_t next_waiter_id_ = 0;
+
+    std::atomic<std::size_t> in_use_{0};
+    std::atomic<std::size_t> high_water_mark_{0};
+    std::atomic<std::size_t> num_waiting_{0};
+};
+
+inline void buffer_pool_thread_cache::flush() {
+    if (auto core = pool.lock(); core && block) {
+        core->unregister_cache(block);
+    }
+    block.reset();
+    pool_id = 0;
+}
+
+inline auto buffer_pool_thread_cache::bind(buffer_pool_core &core) -> buffer_pool_cache_block * {
+    if (pool_id == core.id()) {
+        return block.get();
+    }
+    if (pool_id != 0 && !pool.expired()) {
+        return nullptr;
+    }
+    flush();
+    auto new_block = std::make_shared<buffer_pool_cache_block>(core.thread_cache_size());
+    core.register_cache(new_block);
+    block = std::move(new_block);
+    pool_id = core.id();
+    pool = core.weak_from_this();
+    return block.get();
+}
+
+inline auto buffer_pool_thread_cache::find(const buffer_pool_core &core) const noexcept -> buffer_pool_cache_block * {
+    return pool_id == core.id() ? block.get() : nullptr;
+}
+
+} // namespace detail
+
+inline auto pooled_buffer::data() const noexcept -> ::MCPP_ASIO_NAMESPACE::mutable_buffer {
+    return slab_ != nullptr ? ::MCPP_ASIO_NAMESPACE::mutable_buffer(slab_, pool_->slab_size())
+                            : ::MCPP_ASIO_NAMESPACE::mutable_buffer();
+}
+
+inline auto pooled_buffer::size() const noexcept -> std::size_t {
+    return slab_ != nullptr ? pool_->slab_size() : 0;
+}
+
+inline void pooled_buffer::reset() noexcept {
+    if (slab_ != nullptr) {
+        std::exchange(pool_, nullptr)->release(std::exchange(slab_, nullptr));
+    }
+}
+
+// Fixed number of page-aligned slabs of a fixed size, rounded up to a multiple of the system page size.
+// Released slabs are first kept in a small per-thread cache and otherwise go back to a global free list, or directly
+// to the oldest pending async_acquire. A thread only caches slabs of the first pool it acquires from.
+// When the free list is empty, acquires reclaim slabs from the caches of other threads, and slabs are not cached while
+// acquires are pending, so no slab is stranded in an idle thread's cache.
+// Pending acquires keep their handler's executor from running out of work.
+class buffer_pool {
+  public:
+    using executor_type = ::MCPP_ASIO_NAMESPACE::any_io_executor;
+
+    static constexpr std::size_t default_thread_cache_size = 4;
+
+    buffer_pool(executor_type executor, std::size_t slab_size, std::size_t slab_count,
+                std::size_t thread_cache_size = default_thread_cache_size)
+        : core_(std::make_shared<detail::buffer_pool_core>(std::move(executor), slab_size, slab_count,
+                                                           thread_cache_size)) {}
+
+    buffer_pool(const buffer_pool &) = delete;
+    buffer_pool(buffer_pool &&) noexcept = default;
+    auto operator=(const buffer_pool &) -> buffer_pool & = delete;
+    auto operator=(buffer_pool &&) -> buffer_pool & = delete;
+
+    // Pending acquires fail with operation_aborted, buffers that are still in use stay valid
+    ~buffer_pool() {
+        if (core_) {
+            core_->shutdown();
+        }
+    }
+
+    [[nodiscard]] auto get_executor() const noexcept -> executor_type { return core_->get_executor(); }
+
+    [[nodiscard]] auto slab_size() const noexcept -> std::size_t { return core_->slab_size(); }
+
+    [[nodiscard]] auto stats() const -> buffer_pool_stats { return core_->stats(); }
+
+    // Empty buffer if the pool is exhausted
+    [[nodiscard]] auto try_acquire() -> pooled_buffer { return core_->try_acquire(); }
+
+    // Completes with a buffer once one is available, or with operation_aborted if canceled
+    template <typename CompletionToken>
+    auto async_acquire(CompletionToken &&token) {
+        return ::MCPP_ASIO_NAMESPACE::async_initiate<CompletionToken, void(error_code, pooled_buffer)>(
+            [core = core_](auto handler) {
+                core->async_acquire(detail::buffer_pool_core::handler_type(std::move(handler)));
+            },
+            token);
+    }
+
+  private:
+    std::shared_ptr<detail::buffer_pool_core> core_;
+};
+
+namespace detail {
+
+template <typename... Buffers>
+struct with_buffer_impl {
+    static constexpr const char *trace_name = "with_buffer";
+    static constexpr bool invokes_handler_inline = true;
+
+    std::tuple<Buffers...> buffers_;
+
+    explicit with_buffer_impl(Buffers &&...buffers) : buffers_(std::move(buffers)...) {}
+
+    struct handler_impl {
+        std::tuple<Buffers...> buffers_;
+
+        explicit handler_impl(with_buffer_impl &&token_impl) : buffers_(std::move(token_impl.buffers_)) {}
+    };
+};
+
+} // namespace detail
+
+// Ties the lifetime of the buffers to the completion handler, they are released when the handler is destroyed
+template <typename CT, typename... Buffers>
+    requires(std::is_same_v<Buffers, pooled_buffer> && ...)
+inline auto with_buffer(CT &&token, Buffers &&...buffers) {
+    return detail::make_wrapped_token<detail::with_buffer_impl<Buffers...>>(std::forward<CT>(token),
+                                                                           std::move(buffers)...);
+}
+
+} // namespace mcpp::asio
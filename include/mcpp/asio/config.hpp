@@ -8,6 +8,10 @@
 #define MCPP_ASIO_USE_BOOST 0
 #endif
 
+#ifndef MCPP_ASIO_ENABLE_TRACING
+#define MCPP_ASIO_ENABLE_TRACING 0
+#endif
+
 #if MCPP_ASIO_USE_BOOST
 #include <boost/system/system_error.hpp>
 #define MCPP_ASIO_NAMESPACE boost::asio
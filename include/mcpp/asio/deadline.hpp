@@ -0,0 +1,191 @@
+// Copyright Mika Fischer 2022.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <mcpp/asio/awaitable_utils.hpp>
+#include <mcpp/asio/config.hpp>
+
+#if MCPP_ASIO_USE_BOOST
+#include <boost/asio/any_io_executor.hpp>
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detail/recycling_allocator.hpp>
+#include <boost/asio/error.hpp>
+#include <boost/asio/experimental/deferred.hpp>
+#include <boost/asio/experimental/parallel_group.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/this_coro.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#else
+#include <asio/any_io_executor.hpp>
+#include <asio/awaitable.hpp>
+#include <asio/co_spawn.hpp>
+#include <asio/detail/recycling_allocator.hpp>
+#include <asio/error.hpp>
+#include <asio/experimental/deferred.hpp>
+#include <asio/experimental/parallel_group.hpp>
+#include <asio/steady_timer.hpp>
+#include <asio/this_coro.hpp>
+#include <asio/use_awaitable.hpp>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace mcpp::asio {
+
+using deadline_clock = std::chrono::steady_clock;
+
+// Executor adapter that carries a deadline along with the wrapped executor.
+// Coroutines spawned on it see the deadline through current_deadline(), and since race(), all(), all_settled() and
+// quorum() spawn their children on the executor of the calling coroutine, the children inherit it as well.
+// All properties are forwarded to the wrapped executor, so it converts to any_io_executor.
+// The wrapped executor and the deadline live in one shared node, so the adapter is a single shared_ptr that fits into
+// the small-object buffer of any_io_executor and copying it does not allocate. require() and prefer() do create a new
+// node, which comes from asio's thread-local recycling allocator like the operation states of asio itself.
+class deadline_executor {
+  public:
+    using inner_executor_type = ::MCPP_ASIO_NAMESPACE::any_io_executor;
+
+    deadline_executor(inner_executor_type inner, deadline_clock::time_point deadline)
+        : state_(std::allocate_shared<state>(::MCPP_ASIO_NAMESPACE::detail::recycling_allocator<state>(),
+                                             std::move(inner), deadline)) {}
+
+    [[nodiscard]] auto get_inner_executor() const noexcept -> const inner_executor_type & { return state_->inner; }
+    [[nodiscard]] auto deadline() const noexcept -> deadline_clock::time_point { return state_->deadline; }
+
+    template <typename Function>
+    void execute(Function &&f) const {
+        state_->inner.execute(std::forward<Function>(f));
+    }
+
+    template <typename Property>
+        requires requires(const inner_executor_type &ex, const Property &p) { ex.query(p); }
+    [[nodiscard]] auto query(const Property &p) const -> decltype(auto) {
+        return state_->inner.query(p);
+    }
+
+    template <typename Property>
+        requires requires(const inner_executor_type &ex, const Property &p) { ex.require(p); }
+    [[nodiscard]] auto require(const Property &p) const -> deadline_executor {
+        return {state_->inner.require(p), state_->deadline};
+    }
+
+    template <typename Property>
+        requires requires(const inner_executor_type &ex, const Property &p) { ex.prefer(p); }
+    [[nodiscard]] auto prefer(const Property &p) const -> deadline_executor {
+        return {state_->inner.prefer(p), state_->deadline};
+    }
+
+    friend auto operator==(const deadline_executor &lhs, const deadline_executor &rhs) noexcept -> bool {
+        return lhs.state_ == rhs.state_ ||
+               (lhs.deadline() == rhs.deadline() && lhs.get_inner_executor() == rhs.get_inner_executor());
+    }
+
+  private:
+    struct state {
+        state(inner_executor_type inner, deadline_clock::time_point deadline) noexcept
+            : inner(std::move(inner)), deadline(deadline) {}
+
+        inner_executor_type inner;
+        deadline_clock::time_point deadline;
+    };
+
+    std::shared_ptr<const state> state_;
+};
+
+// Deadline carried by the executor, if any
+template <typename Executor>
+auto get_deadline(const Executor &executor) -> std::optional<deadline_clock::time_point> {
+    if constexpr (std::is_same_v<Executor, deadline_executor>) {
+        return executor.deadline();
+    } else if constexpr (requires { executor.template target<deadline_executor>(); }) {
+        if (const auto *target = executor.template target<deadline_executor>()) {
+            return target->deadline();
+        }
+    }
+    return std::nullopt;
+}
+
+namespace detail {
+
+// Strips an existing deadline, so that nested deadlines do not stack up executor adapters
+template <typename Executor>
+auto without_deadline(const Executor &executor) -> ::MCPP_ASIO_NAMESPACE::any_io_executor {
+    if constexpr (std::is_same_v<Executor, deadline_executor>) {
+        return executor.get_inner_executor();
+    } else if constexpr (requires { executor.template target<deadline_executor>(); }) {
+        if (const auto *target = executor.template target<deadline_executor>()) {
+            return target->get_inner_executor();
+        }
+    }
+    return executor;
+}
+
+} // namespace detail
+
+// Deadline of the current coroutine, if any
+template <typename E = ::MCPP_ASIO_NAMESPACE::any_io_executor>
+auto current_deadline() -> detail::awaitable<std::optional<deadline_clock::time_point>, E> {
+    co_return get_deadline(co_await ::MCPP_ASIO_NAMESPACE::this_coro::executor);
+}
+
+// Time left until the deadline of the current coroutine, zero if it has passed and duration::max() if there is none.
+// Allows skipping work that cannot finish in time anyway.
+template <typename E = ::MCPP_ASIO_NAMESPACE::any_io_executor>
+auto remaining_budget() -> detail::awaitable<deadline_clock::duration, E> {
+    auto deadline = get_deadline(co_await ::MCPP_ASIO_NAMESPACE::this_coro::executor);
+    if (!deadline) {
+        co_return deadline_clock::duration::max();
+    }
+    co_return std::max(*deadline - deadline_clock::now(), deadline_clock::duration::zero());
+}
+
+// Runs the awaitable with the given deadline, which it and everything it spawns through the combinators inherit.
+// If the deadline expires first, the awaitable is canceled and system_error(timed_out) is thrown. If the caller is
+// canceled instead, the awaitable is canceled as well and the cancellation is propagated, not reported as a timeout.
+// A single timer enforces the deadline for the whole subtree. If an enclosing deadline is already earlier, the
+// awaitable simply runs under that one and no timer is created.
+template <typename T, typename E>
+auto with_deadline(deadline_clock::time_point deadline, detail::awaitable<T, E> awaitable) -> detail::awaitable<T, E> {
+    static_assert(std::is_constructible_v<E, deadline_executor>);
+    using ::MCPP_ASIO_NAMESPACE::experimental::deferred, ::MCPP_ASIO_NAMESPACE::experimental::make_parallel_group,
+        ::MCPP_ASIO_NAMESPACE::experimental::wait_for_one;
+    using traits = detail::awaitable_traits<T>;
+
+    auto executor = co_await ::MCPP_ASIO_NAMESPACE::this_coro::executor;
+    if (auto inherited = get_deadline(executor); inherited && *inherited <= deadline) {
+        co_return co_await std::move(awaitable);
+    }
+
+    auto timer = ::MCPP_ASIO_NAMESPACE::steady_timer(executor, deadline);
+    auto child_executor = deadline_executor(detail::without_deadline(executor), deadline);
+    auto results = co_await make_parallel_group(co_spawn(child_executor, std::move(awaitable), deferred),
+                                                timer.async_wait(deferred))
+                       .async_wait(wait_for_one(), ::MCPP_ASIO_NAMESPACE::use_awaitable_t<E>{});
+    if (std::get<0>(results)[0] == 1) {
+        // The timer also completes first, with operation_aborted, when the whole group is canceled from outside
+        if (auto timer_error = std::get<std::tuple_size_v<decltype(results)> - 1>(results)) {
+            throw system_error(timer_error);
+        }
+        throw system_error(make_error_code(::MCPP_ASIO_NAMESPACE::error::timed_out));
+    }
+    if constexpr (std::is_void_v<T>) {
+        traits::template get_group_result_or_throw<0>(results);
+    } else {
+        co_return traits::template get_group_result_or_throw<0>(results);
+    }
+}
+
+template <typename T, typename E>
+auto with_timeout(deadline_clock::duration timeout, detail::awaitable<T, E> awaitable) -> detail::awaitable<T, E> {
+    return with_deadline(deadline_clock::now() + timeout, std::move(awaitable));
+}
+
+} // namespace mcpp::asio
@@ -0,0 +1,438 @@
+// Copyright Mika Fischer 2022.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <mcpp/asio/async_op_utils.hpp>
+#include <mcpp/asio/config.hpp>
+
+#if MCPP_ASIO_USE_BOOST
+#include <boost/asio/any_io_executor.hpp>
+#include <boost/asio/associated_allocator.hpp>
+#include <boost/asio/associated_cancellation_slot.hpp>
+#include <boost/asio/associated_executor.hpp>
+#include <boost/asio/associator.hpp>
+#include <boost/asio/cancellation_signal.hpp>
+#include <boost/asio/detail/recycling_allocator.hpp>
+#else
+#include <asio/any_io_executor.hpp>
+#include <asio/associated_allocator.hpp>
+#include <asio/associated_cancellation_slot.hpp>
+#include <asio/associated_executor.hpp>
+#include <asio/associator.hpp>
+#include <asio/cancellation_signal.hpp>
+#include <asio/detail/recycling_allocator.hpp>
+#endif
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace mcpp::asio {
+
+// Large enough for an awaitable or promise handler wrapped by a couple of token adapters.
+inline constexpr std::size_t default_erased_handler_buffer_size = 8 * sizeof(void *);
+
+template <typename Signature, typename Executor = ::MCPP_ASIO_NAMESPACE::any_io_executor,
+          std::size_t BufferSize = default_erased_handler_buffer_size>
+class erased_handler;
+
+namespace detail {
+
+// Like asio itself, handlers with the default allocator get the thread-local recycling allocator
+template <typename T>
+using recycling_allocator = ::MCPP_ASIO_NAMESPACE::detail::recycling_allocator<T>;
+
+template <typename Handler>
+inline constexpr bool has_default_allocator =
+    std::is_same_v<::MCPP_ASIO_NAMESPACE::associated_allocator_t<Handler>, std::allocator<void>>;
+
+template <typename Handler>
+using handler_allocator_t =
+    std::conditional_t<has_default_allocator<Handler>, recycling_allocator<Handler>,
+                       typename std::allocator_traits<
+                           ::MCPP_ASIO_NAMESPACE::associated_allocator_t<Handler>>::template rebind_alloc<Handler>>;
+
+template <typename Handler>
+inline auto get_handler_allocator(const Handler &handler) -> handler_allocator_t<Handler> {
+    if constexpr (has_default_allocator<Handler>) {
+        return handler_allocator_t<Handler>();
+    } else {
+        return handler_allocator_t<Handler>(::MCPP_ASIO_NAMESPACE::get_associated_allocator(handler));
+    }
+}
+
+template <typename Handler, std::size_t BufferSize>
+inline constexpr bool fits_inline = sizeof(Handler) <= BufferSize && alignof(Handler) <= alignof(std::max_align_t) &&
+                                    std::is_nothrow_move_constructible_v<Handler>;
+
+// Stores the handler in the inline buffer of the erased_handler
+template <typename Handler>
+struct inline_storage {
+    static constexpr bool is_inline = true;
+
+    static auto get(void *buffer) noexcept -> Handler * { return std::launder(static_cast<Handler *>(buffer)); }
+
+    static auto get(const void *buffer) noexcept -> const Handler * {
+        return std::launder(static_cast<const Handler *>(buffer));
+    }
+
+    template <typename H>
+    static void construct(void *buffer, H &&handler) {
+        ::new (buffer) Handler(std::forward<H>(handler));
+    }
+
+    static void move(void *from, void *to) noexcept {
+        ::new (to) Handler(std::move(*get(from)));
+        get(from)->~Handler();
+    }
+
+    static auto release(void *buffer) -> Handler {
+        auto handler = Handler(std::move(*get(buffer)));
+        get(buffer)->~Handler();
+        return handler;
+    }
+
+    static void destroy(void *buffer) noexcept { get(buffer)->~Handler(); }
+};
+
+// Stores a pointer to the handler in the inline buffer, the handler itself is allocated with its associated allocator
+template <typename Handler>
+struct heap_storage {
+    using allocator_traits = std::allocator_traits<handler_allocator_t<Handler>>;
+
+    static constexpr bool is_inline = false;
+
+    static auto get(void *buffer) noexcept -> Handler * { return *std::launder(static_cast<Handler **>(buffer)); }
+
+    static auto get(const void *buffer) noexcept -> const Handler * {
+        return *std::launder(static_cast<Handler *const *>(buffer));
+    }
+
+    template <typename H>
+    static void construct(void *buffer, H &&handler) {
+        auto alloc = get_handler_allocator(handler);
+        auto *ptr = allocator_traits::allocate(alloc, 1);
+        try {
+            allocator_traits::construct(alloc, ptr, std::forward<H>(handler));
+        } catch (...) {
+            allocator_traits::deallocate(alloc, ptr, 1);
+            throw;
+        }
+        ::new (buffer) Handler *(ptr);
+    }
+
+    static void move(void *from, void *to) noexcept { ::new (to) Handler *(get(from)); }
+
+    // The memory is freed before the handler is invoked, so that it can be reused by the next operation
+    static auto release(void *buffer) -> Handler {
+        auto *ptr = get(buffer);
+        auto alloc = get_handler_allocator(*ptr);
+        auto handler = Handler(std::move(*ptr));
+        allocator_traits::destroy(alloc, ptr);
+        allocator_traits::deallocate(alloc, ptr, 1);
+        return handler;
+    }
+
+    static void destroy(void *buffer) noexcept {
+        auto *ptr = get(buffer);
+        auto alloc = get_handler_allocator(*ptr);
+        allocator_traits::destroy(alloc, ptr);
+        allocator_traits::deallocate(alloc, ptr, 1);
+    }
+};
+
+// Associated allocators are copied into an erased_allocator, so they must fit into this size. Allocators with more
+// state than that can hold it through a pointer. std::allocator is replaced by asio's recycling allocator.
+inline constexpr std::size_t erased_allocator_state_size = 2 * sizeof(void *);
+
+struct erased_allocator_vtable {
+    void *(*allocate)(const void *state, std::size_t n);
+    void (*deallocate)(const void *state, void *ptr, std::size_t n);
+    void (*copy)(const void *from, void *to) noexcept;
+    void (*destroy)(void *state) noexcept;
+    bool (*equal)(const void *lhs, const void *rhs) noexcept;
+};
+
+template <typename Allocator>
+struct erased_allocator_functions {
+    using allocator_type = typename std::allocator_traits<Allocator>::template rebind_alloc<std::max_align_t>;
+
+    static auto get(const void *state) noexcept -> const allocator_type & {
+        return *std::launder(static_cast<const allocator_type *>(state));
+    }
+
+    static auto allocate(const void *state, std::size_t n) -> void * {
+        auto allocator = get(state);
+        return std::allocator_traits<allocator_type>::allocate(allocator, n);
+    }
+
+    static void deallocate(const void *state, void *ptr, std::size_t n) {
+        auto allocator = get(state);
+        std::allocator_traits<allocator_type>::deallocate(allocator, static_cast<std::max_align_t *>(ptr), n);
+    }
+
+    static void copy(const void *from, void *to) noexcept { ::new (to) allocator_type(get(from)); }
+
+    static void destroy(void *state) noexcept { std::launder(static_cast<allocator_type *>(state))->~allocator_type(); }
+
+    static auto equal(const void *lhs, const void *rhs) noexcept -> bool { return get(lhs) == get(rhs); }
+
+    static constexpr auto vtable = erased_allocator_vtable{&allocate, &deallocate, &copy, &destroy, &equal};
+};
+
+template <typename T>
+class erased_allocator;
+
+template <typename T>
+inline constexpr bool is_erased_allocator = false;
+
+template <typename T>
+inline constexpr bool is_erased_allocator<erased_allocator<T>> = true;
+
+// Allocator that holds a copy of the associated allocator of a type-erased handler.
+// Allocations are done in units of std::max_align_t, over-aligned types are not supported.
+template <typename T>
+class erased_allocator {
+  public:
+    using value_type = T;
+
+    template <typename U>
+    struct rebind {
+        using other = erased_allocator<U>;
+    };
+
+    erased_allocator() noexcept = default;
+
+    template <typename Allocator>
+        requires(!is_erased_allocator<std::decay_t<Allocator>>)
+    explicit erased_allocator(const Allocator &allocator) noexcept {
+        using functions = erased_allocator_functions<Allocator>;
+        using allocator_type = typename functions::allocator_type;
+        if constexpr (!std::is_same_v<allocator_type, std::allocator<std::max_align_t>>) {
+            static_assert(sizeof(allocator_type) <= erased_allocator_state_size &&
+                              alignof(allocator_type) <= alignof(void *),
+                          "the associated allocator does not fit into erased_allocator, hold its state by pointer");
+            static_assert(std::is_nothrow_copy_constructible_v<allocator_type>);
+            ::new (static_cast<void *>(state_)) allocator_type(allocator);
+            vtable_ = &functions::vtable;
+        }
+    }
+
+    erased_allocator(const erased_allocator &other) noexcept { copy_from(other); }
+
+    template <typename U>
+    // NOLINTNEXTLINE(hicpp-explicit-conversions)
+    erased_allocator(const erased_allocator<U> &other) noexcept {
+        copy_from(other);
+    }
+
+    auto operator=(const erased_allocator &other) noexcept -> erased_allocator & {
+        if (this != &other) {
+            reset();
+            copy_from(other);
+        }
+        return *this;
+    }
+
+    ~erased_allocator() { reset(); }
+
+    auto allocate(std::size_t n) const -> T * {
+        static_assert(alignof(T) <= alignof(std::max_align_t));
+        if (vtable_ == nullptr) {
+            return static_cast<T *>(static_cast<void *>(recycling_allocator<std::max_align_t>().allocate(units(n))));
+        }
+        return static_cast<T *>(vtable_->allocate(state_, units(n)));
+    }
+
+    void deallocate(T *ptr, std::size_t n) const {
+        if (vtable_ == nullptr) {
+            recycling_allocator<std::max_align_t>().deallocate(
+                static_cast<std::max_align_t *>(static_cast<void *>(ptr)), units(n));
+            return;
+        }
+        vtable_->deallocate(state_, ptr, units(n));
+    }
+
+    template <typename U>
+    auto operator==(const erased_allocator<U> &other) const noexcept -> bool {
+        return vtable_ == other.vtable_ && (vtable_ == nullptr || vtable_->equal(state_, other.state_));
+    }
+
+  private:
+    template <typename>
+    friend class erased_allocator;
+
+    static constexpr auto units(std::size_t n) -> std::size_t {
+        return (n * sizeof(T) + sizeof(std::max_align_t) - 1) / sizeof(std::max_align_t);
+    }
+
+    template <typename U>
+    void copy_from(const erased_allocator<U> &other) noexcept {
+        if (other.vtable_ != nullptr) {
+            other.vtable_->copy(other.state_, state_);
+            vtable_ = other.vtable_;
+        }
+    }
+
+    void reset() noexcept {
+        if (vtable_ != nullptr) {
+            std::exchange(vtable_, nullptr)->destroy(state_);
+        }
+    }
+
+    const erased_allocator_vtable *vtable_ = nullptr;
+    alignas(void *) std::byte state_[erased_allocator_state_size]{};
+};
+
+template <typename Executor, typename... Args>
+struct erased_handler_vtable {
+    bool is_inline;
+    void (*invoke)(void *buffer, Args &&...args);
+    void (*move)(void *from, void *to) noexcept;
+    void (*destroy)(void *buffer) noexcept;
+    Executor (*executor)(const void *buffer, const Executor &candidate);
+    ::MCPP_ASIO_NAMESPACE::cancellation_slot (*cancellation_slot)(const void *buffer);
+    erased_allocator<void> (*allocator)(const void *buffer);
+};
+
+template <typename Handler, typename Storage, typename Executor, typename... Args>
+struct erased_handler_functions {
+    static auto get(const void *buffer) noexcept -> const Handler & { return *Storage::get(buffer); }
+
+    static void invoke(void *buffer, Args &&...args) {
+        Storage::release(buffer)(std::forward<Args>(args)...);
+    }
+
+    static auto executor(const void *buffer, const Executor &candidate) -> Executor {
+        return ::MCPP_ASIO_NAMESPACE::get_associated_executor(get(buffer), candidate);
+    }
+
+    static auto cancellation_slot(const void *buffer) -> ::MCPP_ASIO_NAMESPACE::cancellation_slot {
+        return ::MCPP_ASIO_NAMESPACE::get_associated_cancellation_slot(get(buffer));
+    }
+
+    static auto allocator(const void *buffer) -> erased_allocator<void> {
+        return erased_allocator<void>(::MCPP_ASIO_NAMESPACE::get_associated_allocator(get(buffer)));
+    }
+
+    static constexpr auto vtable = erased_handler_vtable<Executor, Args...>{
+        Storage::is_inline, &invoke, &Storage::move, &Storage::destroy, &executor, &cancellation_slot, &allocator,
+    };
+};
+
+} // namespace detail
+
+// Move-only type-erased completion handler.
+// Handlers that fit into BufferSize bytes and are nothrow movable are stored inline, all others are allocated with
+// their associated allocator. The associated executor, allocator and cancellation slot of the stored handler are
+// forwarded. The associated allocator is kept by value, so it stays valid when the erased_handler is moved.
+template <typename... Args, typename Executor, std::size_t BufferSize>
+class erased_handler<void(Args...), Executor, BufferSize> {
+  public:
+    erased_handler() noexcept = default;
+
+    template <typename H>
+        requires(!detail::decays_to<H, erased_handler> && std::is_invocable_v<std::decay_t<H> &&, Args...>)
+    explicit erased_handler(H &&handler) {
+        using handler_type = std::decay_t<H>;
+        using storage = std::conditional_t<detail::fits_inline<handler_type, BufferSize>,
+                                           detail::inline_storage<handler_type>, detail::heap_storage<handler_type>>;
+        storage::construct(buffer_, std::forward<H>(handler));
+        vtable_ = &detail::erased_handler_functions<handler_type, storage, Executor, Args...>::vtable;
+    }
+
+    erased_handler(erased_handler &&other) noexcept { move_from(other); }
+
+    auto operator=(erased_handler &&other) noexcept -> erased_handler & {
+        if (this != &other) {
+            reset();
+            move_from(other);
+        }
+        return *this;
+    }
+
+    erased_handler(const erased_handler &) = delete;
+    auto operator=(const erased_handler &) -> erased_handler & = delete;
+
+    ~erased_handler() { reset(); }
+
+    void operator()(Args... args) && {
+        if (vtable_ == nullptr) {
+            throw std::bad_function_call();
+        }
+        auto *vtable = std::exchange(vtable_, nullptr);
+        vtable->invoke(buffer_, std::forward<Args>(args)...);
+    }
+
+    explicit operator bool() const noexcept { return vtable_ != nullptr; }
+
+    [[nodiscard]] auto stored_inline() const noexcept -> bool { return vtable_ != nullptr && vtable_->is_inline; }
+
+    [[nodiscard]] auto get_executor(const Executor &candidate) const -> Executor {
+        return vtable_ != nullptr ? vtable_->executor(buffer_, candidate) : candidate;
+    }
+
+    [[nodiscard]] auto get_cancellation_slot() const -> ::MCPP_ASIO_NAMESPACE::cancellation_slot {
+        return vtable_ != nullptr ? vtable_->cancellation_slot(buffer_) : ::MCPP_ASIO_NAMESPACE::cancellation_slot();
+    }
+
+    [[nodiscard]] auto get_allocator() const -> detail::erased_allocator<void> {
+        return vtable_ != nullptr ? vtable_->allocator(buffer_) : detail::erased_allocator<void>();
+    }
+
+  private:
+    void move_from(erased_handler &other) noexcept {
+        if (other.vtable_ != nullptr) {
+            other.vtable_->move(other.buffer_, buffer_);
+            vtable_ = std::exchange(other.vtable_, nullptr);
+        }
+    }
+
+    void reset() noexcept {
+        if (vtable_ != nullptr) {
+            std::exchange(vtable_, nullptr)->destroy(buffer_);
+        }
+    }
+
+    alignas(std::max_align_t) std::byte buffer_[BufferSize < sizeof(void *) ? sizeof(void *) : BufferSize];
+    const detail::erased_handler_vtable<Executor, Args...> *vtable_ = nullptr;
+};
+
+} // namespace mcpp::asio
+
+namespace MCPP_ASIO_NAMESPACE {
+
+template <typename Signature, typename Executor, std::size_t BufferSize, typename Candidate>
+struct associator<associated_executor, mcpp::asio::erased_handler<Signature, Executor, BufferSize>, Candidate> {
+    using type = Executor;
+    static auto get(const mcpp::asio::erased_handler<Signature, Executor, BufferSize> &handler,
+                    const Candidate &candidate = Candidate()) noexcept -> type {
+        return handler.get_executor(Executor(candidate));
+    }
+};
+
+template <typename Signature, typename Executor, std::size_t BufferSize, typename Default>
+struct associator<associated_allocator, mcpp::asio::erased_handler<Signature, Executor, BufferSize>, Default> {
+    using type = mcpp::asio::detail::erased_allocator<void>;
+    static auto get(const mcpp::asio::erased_handler<Signature, Executor, BufferSize> &handler,
+                    const Default & /*default*/ = Default()) noexcept -> type {
+        return handler.get_allocator();
+    }
+};
+
+template <typename Signature, typename Executor, std::size_t BufferSize, typename Default>
+struct associator<associated_cancellation_slot, mcpp::asio::erased_handler<Signature, Executor, BufferSize>,
+                  Default> {
+    using type = cancellation_slot;
+    static auto get(const mcpp::asio::erased_handler<Signature, Executor, BufferSize> &handler,
+                    const Default & /*default*/ = Default()) noexcept -> type {
+        return handler.get_cancellation_slot();
+    }
+};
+
+} // namespace MCPP_ASIO_NAMESPACE
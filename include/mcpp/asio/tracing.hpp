@@ -0,0 +1,227 @@
+// Copyright Mika Fischer 2022.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <mcpp/asio/config.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Async causality tracing.
+// When MCPP_ASIO_ENABLE_TRACING is set, wrapped tokens and the awaitable combinators record begin/end spans with
+// links to the span that was active when they were started. Records go into per-thread ring buffers and can be
+// written out in the Chrome trace event format, which can be opened in Perfetto or chrome://tracing.
+// The recording API itself is always available, but nothing in the library calls it unless tracing is enabled.
+namespace mcpp::asio::tracing {
+
+using span_id = std::uint64_t;
+
+enum class phase : std::uint8_t { begin, end };
+
+struct record {
+    span_id id = 0;
+    span_id parent = 0;
+    const char *name = nullptr; // Must have static storage duration
+    std::uint64_t timestamp_ns = 0;
+    std::int32_t child_index = -1;
+    phase ph = phase::begin;
+};
+
+namespace detail {
+
+// Single producer ring buffer, only the owning thread writes to it.
+// Readers see a consistent head, the records themselves should only be read once the traced work has quiesced.
+// Clearing from another thread only moves the start of the readable range up to the head, it never touches the head.
+class ring_buffer {
+  public:
+    static constexpr std::size_t capacity = std::size_t{1} << 14U;
+
+    explicit ring_buffer(std::uint32_t thread_index) : thread_index_(thread_index) {}
+
+    void push(const record &rec) noexcept {
+        auto head = head_.load(std::memory_order_relaxed);
+        records_[head % capacity] = rec;
+        head_.store(head + 1, std::memory_order_release);
+    }
+
+    template <typename F>
+    void for_each(F &&f) const {
+        auto head = head_.load(std::memory_order_acquire);
+        auto first = std::max(head > capacity ? head - capacity : 0, start_.load(std::memory_order_acquire));
+        for (auto i = first; i < head; ++i) {
+            f(records_[i % capacity]);
+        }
+    }
+
+    void clear() noexcept {
+        auto head = head_.load(std::memory_order_acquire);
+        auto start = start_.load(std::memory_order_relaxed);
+        while (start < head && !start_.compare_exchange_weak(start, head, std::memory_order_release)) {
+        }
+    }
+
+    [[nodiscard]] auto thread_index() const noexcept -> std::uint32_t { return thread_index_; }
+
+  private:
+    std::array<record, capacity> records_{};
+    std::atomic<std::uint64_t> head_{0};
+    // Records before this index have been cleared
+    std::atomic<std::uint64_t> start_{0};
+    std::uint32_t thread_index_;
+};
+
+struct registry {
+    std::mutex mutex;
+    std::vector<std::shared_ptr<ring_buffer>> buffers;
+    std::atomic<span_id> next_span_id{1};
+};
+
+inline auto get_registry() -> registry & {
+    static auto instance = registry();
+    return instance;
+}
+
+// Buffers are owned by the registry as well, so records survive the thread that wrote them.
+inline auto local_buffer() -> ring_buffer & {
+    thread_local auto buffer = [] {
+        auto &reg = get_registry();
+        auto lock = std::lock_guard(reg.mutex);
+        auto result = std::make_shared<ring_buffer>(static_cast<std::uint32_t>(reg.buffers.size() + 1));
+        reg.buffers.push_back(result);
+        return result;
+    }();
+    return *buffer;
+}
+
+inline thread_local span_id current_span = 0;
+
+inline auto now_ns() noexcept -> std::uint64_t {
+    auto since_epoch = std::chrono::steady_clock::now().time_since_epoch();
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(since_epoch).count());
+}
+
+inline void write_escaped(std::ostream &os, const char *str) {
+    for (; str != nullptr && *str != '\0'; ++str) {
+        if (*str == '"' || *str == '\\') {
+            os << '\\';
+        }
+        os << *str;
+    }
+}
+
+} // namespace detail
+
+// The span that is currently being completed on this thread, or 0.
+inline auto current() noexcept -> span_id {
+    return detail::current_span;
+}
+
+inline auto begin_span(const char *name, span_id parent = current(), std::int32_t child_index = -1) -> span_id {
+    auto id = detail::get_registry().next_span_id.fetch_add(1, std::memory_order_relaxed);
+    detail::local_buffer().push({id, parent, name, detail::now_ns(), child_index, phase::begin});
+    return id;
+}
+
+inline void end_span(span_id id, const char *name) {
+    detail::local_buffer().push({id, 0, name, detail::now_ns(), -1, phase::end});
+}
+
+// Makes the given span current for the lifetime of the object, so that operations started meanwhile are linked to it.
+class current_span_scope {
+  public:
+    explicit current_span_scope(span_id id) noexcept : previous_(detail::current_span) { detail::current_span = id; }
+    current_span_scope(const current_span_scope &) = delete;
+    current_span_scope(current_span_scope &&) = delete;
+    auto operator=(const current_span_scope &) -> current_span_scope & = delete;
+    auto operator=(current_span_scope &&) -> current_span_scope & = delete;
+    ~current_span_scope() { detail::current_span = previous_; }
+
+  private:
+    span_id previous_;
+};
+
+// Records a span covering the lifetime of the object.
+class scoped_span {
+  public:
+    explicit scoped_span(const char *name, span_id parent = current(), std::int32_t child_index = -1)
+        : name_(name), id_(begin_span(name, parent, child_index)) {}
+    scoped_span(const scoped_span &) = delete;
+    scoped_span(scoped_span &&) = delete;
+    auto operator=(const scoped_span &) -> scoped_span & = delete;
+    auto operator=(scoped_span &&) -> scoped_span & = delete;
+    ~scoped_span() { end_span(id_, name_); }
+
+    [[nodiscard]] auto id() const noexcept -> span_id { return id_; }
+
+  private:
+    const char *name_;
+    span_id id_;
+};
+
+// Discards all records collected so far. Safe while traced work is running, records written concurrently with the call
+// may or may not be kept.
+inline void clear() {
+    auto &reg = detail::get_registry();
+    auto lock = std::lock_guard(reg.mutex);
+    for (const auto &buffer : reg.buffers) {
+        buffer->clear();
+    }
+}
+
+// Copy of all records collected so far, grouped by thread and in the order in which they were recorded.
+inline auto snapshot() -> std::vector<record> {
+    auto &reg = detail::get_registry();
+    auto lock = std::lock_guard(reg.mutex);
+    auto result = std::vector<record>();
+    for (const auto &buffer : reg.buffers) {
+        buffer->for_each([&](const record &rec) { result.push_back(rec); });
+    }
+    return result;
+}
+
+// Writes all records in the Chrome trace event format as async begin/end events keyed by span id.
+inline void write_chrome_trace(std::ostream &os) {
+    auto &reg = detail::get_registry();
+    auto lock = std::lock_guard(reg.mutex);
+    os << R"({"displayTimeUnit":"ns","traceEvents":[)";
+    auto first = true;
+    for (const auto &buffer : reg.buffers) {
+        buffer->for_each([&](const record &rec) {
+            os << (first ? "\n" : ",\n");
+            first = false;
+            os << R"({"name":")";
+            detail::write_escaped(os, rec.name);
+            os << R"(","cat":"mcpp.asio","ph":")" << (rec.ph == phase::begin ? 'b' : 'e') << R"(","id":)" << rec.id
+               << R"(,"pid":1,"tid":)" << buffer->thread_index() << R"(,"ts":)" << rec.timestamp_ns / 1000 << '.'
+               << rec.timestamp_ns / 100 % 10 << rec.timestamp_ns / 10 % 10 << rec.timestamp_ns % 10;
+            if (rec.ph == phase::begin) {
+                os << R"(,"args":{"parent":)" << rec.parent;
+                if (rec.child_index >= 0) {
+                    os << R"(,"child":)" << rec.child_index;
+                }
+                os << '}';
+            }
+            os << '}';
+        });
+    }
+    os << "\n]}\n";
+}
+
+inline void write_chrome_trace(const std::string &path) {
+    auto file = std::ofstream(path);
+    write_chrome_trace(file);
+}
+
+} // namespace mcpp::asio::tracing
@@ -23,6 +23,9 @@ MCPP_ASIO_FOREACH_SIGNATURE_QUALIFIER(X)
 #undef X
 
 struct transform_noexcept_impl {
+    static constexpr const char *trace_name = "transform_noexcept";
+    static constexpr bool invokes_handler_inline = true;
+
     template <typename Signature>
     using transform_signature = typename transform_noexcept_signature<Signature>::type;
 
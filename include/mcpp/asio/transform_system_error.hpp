@@ -25,6 +25,9 @@ MCPP_ASIO_FOREACH_SIGNATURE_QUALIFIER(X)
 #undef X
 
 struct transform_system_error_impl {
+    static constexpr const char *trace_name = "transform_system_error";
+    static constexpr bool invokes_handler_inline = true;
+
     template <typename Signature>
     using transform_signature = typename transform_system_error_signature<Signature>::type;
 
@@ -23,6 +23,9 @@ using work_guard = ::MCPP_ASIO_NAMESPACE::executor_work_guard<E>;
 
 template <typename... Executor>
 struct with_work_guard_impl {
+    static constexpr const char *trace_name = "with_work_guard";
+    static constexpr bool invokes_handler_inline = true;
+
     std::tuple<work_guard<Executor>...> work_guards_;
 
     explicit with_work_guard_impl(work_guard<Executor> &&...work_guards) : work_guards_(std::move(work_guards)...) {}
@@ -0,0 +1,160 @@
+#if defined(__clang__) && !defined(ASIO_HAS_CO_AWAIT)
+#define ASIO_HAS_CO_AWAIT 1
+#endif
+
+#include <mcpp/asio/async_generator.hpp>
+
+#include <asio/detached.hpp>
+#include <asio/io_context.hpp>
+
+#include <doctest/doctest.h>
+
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace ::MCPP_ASIO_NAMESPACE;
+using namespace mcpp::asio;
+using namespace std::literals;
+
+namespace {
+auto count_to(int n, std::size_t buffer_size = 0) -> awaitable<async_generator<int>> {
+    co_return make_async_generator<int>(
+        co_await this_coro::executor,
+        [n](async_yield<int> yield) -> awaitable<void> {
+            for (auto i = 0; i < n; ++i) {
+                co_await yield(i);
+            }
+        },
+        buffer_size);
+}
+} // namespace
+
+TEST_CASE("async_generator.values_in_order") {
+    auto ioc = io_context();
+    auto values = std::vector<int>();
+    co_spawn(
+        ioc,
+        [&]() -> awaitable<void> {
+            auto generator = co_await count_to(3);
+            while (auto value = co_await generator.next()) {
+                values.push_back(*value);
+            }
+            auto after_end = co_await generator.next();
+            REQUIRE(!after_end);
+        },
+        detached);
+    ioc.run();
+    REQUIRE(values == std::vector{0, 1, 2});
+}
+
+TEST_CASE("async_generator.next_n") {
+    auto ioc = io_context();
+    auto values = std::vector<int>();
+    co_spawn(
+        ioc,
+        [&]() -> awaitable<void> {
+            auto generator = co_await count_to(10, 4);
+            while (true) {
+                auto batch = co_await generator.next_n(4);
+                if (batch.empty()) {
+                    break;
+                }
+                REQUIRE(batch.size() <= 4);
+                values.insert(values.end(), batch.begin(), batch.end());
+            }
+        },
+        detached);
+    ioc.run();
+    REQUIRE(values == std::vector{0, 1, 2, 3, 4, 5, 6, 7, 8, 9});
+}
+
+TEST_CASE("async_generator.producer_exception") {
+    auto ioc = io_context();
+    co_spawn(
+        ioc,
+        [&]() -> awaitable<void> {
+            auto generator = make_async_generator<int>(co_await this_coro::executor,
+                                                       [](async_yield<int> yield) -> awaitable<void> {
+                                                           co_await yield(1);
+                                                           throw std::runtime_error("producer");
+                                                       });
+            auto first = co_await generator.next();
+            REQUIRE(*first == 1);
+            try {
+                co_await generator.next();
+                REQUIRE(false);
+            } catch (std::runtime_error &e) {
+                REQUIRE(e.what() == "producer"sv);
+            }
+        },
+        detached);
+    ioc.run();
+}
+
+TEST_CASE("async_generator.destroying_cancels_producer") {
+    auto ioc = io_context();
+    auto producer_stopped = false;
+    co_spawn(
+        ioc,
+        [&]() -> awaitable<void> {
+            auto generator = make_async_generator<int>(co_await this_coro::executor,
+                                                       [&](async_yield<int> yield) -> awaitable<void> {
+                                                           try {
+                                                               for (auto i = 0;; ++i) {
+                                                                   co_await yield(i);
+                                                               }
+                                                           } catch (...) {
+                                                               producer_stopped = true;
+                                                               throw;
+                                                           }
+                                                       });
+            auto first = co_await generator.next();
+            REQUIRE(*first == 0);
+        },
+        detached);
+    ioc.run();
+    REQUIRE(producer_stopped);
+}
+
+TEST_CASE("async_generator.merge") {
+    auto ioc = io_context();
+    auto counts = std::vector<int>(2);
+    co_spawn(
+        ioc,
+        [&]() -> awaitable<void> {
+            auto merged = merge(co_await count_to(3), co_await count_to(5));
+            while (auto value = co_await merged.next()) {
+                ++counts[value->index()];
+            }
+        },
+        detached);
+    ioc.run();
+    REQUIRE(counts == std::vector{3, 5});
+}
+
+TEST_CASE("async_generator.multi_threaded") {
+    auto ioc = io_context();
+    auto values = std::vector<int>();
+    co_spawn(
+        ioc,
+        [&]() -> awaitable<void> {
+            auto generator = co_await count_to(1000, 8);
+            while (auto value = co_await generator.next()) {
+                values.push_back(*value);
+            }
+        },
+        detached);
+    auto threads = std::vector<std::thread>();
+    for (auto i = 0; i < 4; ++i) {
+        threads.emplace_back([&] { ioc.run(); });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    REQUIRE(values.size() == 1000);
+    for (auto i = 0; i < 1000; ++i) {
+        REQUIRE(values[i] == i);
+    }
+}
@@ -1 +1,129 @@
-#include <mcpp/asio/async_op_utils.hpp>
\ No newline at end of file
+#include <mcpp/asio/async_op_utils.hpp>
+#include <mcpp/asio/transform_system_error.hpp>
+#include <mcpp/asio/with_work_guard.hpp>
+
+#include <asio/associated_executor.hpp>
+#include <asio/async_result.hpp>
+#include <asio/bind_executor.hpp>
+#include <asio/experimental/promise.hpp>
+#include <asio/io_context.hpp>
+
+#include <doctest/doctest.h>
+
+#include <exception>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+using namespace mcpp::asio;
+
+namespace {
+struct add_one_impl {
+    static constexpr bool invokes_handler_inline = true;
+
+    struct handler_impl {
+        void operator()(auto &handler, int i) && { std::move(handler)(i + 1); }
+    };
+};
+
+struct to_string_impl {
+    static constexpr bool invokes_handler_inline = true;
+
+    template <typename Signature>
+    using transform_signature = void(std::string);
+
+    struct handler_impl {
+        void operator()(auto &handler, int i) && { std::move(handler)(std::to_string(i)); }
+    };
+};
+
+// Does not declare invokes_handler_inline, so it must get the real handler
+struct deferring_impl {
+    struct handler_impl {
+        void operator()(auto &handler, int i) && { std::move(handler)(i); }
+    };
+};
+
+struct executor_probe_impl {
+    static constexpr bool invokes_handler_inline = true;
+
+    struct handler_impl {
+        void operator()(auto &handler, int i) && {
+            using executor = decltype(::MCPP_ASIO_NAMESPACE::get_associated_executor(handler));
+            std::move(handler)(std::is_same_v<executor, ::MCPP_ASIO_NAMESPACE::system_executor> ? -1 : i);
+        }
+    };
+};
+
+template <typename T>
+struct is_wrapped_handler : std::false_type {};
+
+template <typename Handler, typename Impl>
+struct is_wrapped_handler<detail::wrapped_handler<Handler, Impl>> : std::true_type {};
+} // namespace
+
+TEST_CASE("async_op_utils.nested_wrapped_tokens_are_fused") {
+    auto result = std::string();
+    auto handler = [&](std::string s) { result = std::move(s); };
+    auto token = detail::make_wrapped_token<add_one_impl>(detail::make_wrapped_token<to_string_impl>(handler));
+
+    using fused = detail::fused_impl<add_one_impl, to_string_impl>;
+    static_assert(std::is_same_v<decltype(token), detail::wrapped_token<fused, decltype(handler)>>);
+    static_assert(std::is_same_v<detail::transform_signature_t<void(int), fused>, void(std::string)>);
+
+    ::MCPP_ASIO_NAMESPACE::async_result<decltype(token), void(int)>::initiate(
+        [](auto wrapped_handler) { std::move(wrapped_handler)(41); }, std::move(token));
+    REQUIRE(result == "42");
+}
+
+TEST_CASE("async_op_utils.only_inline_impls_are_fused") {
+    auto result = 0;
+    auto handler = [&](int i) { result = i; };
+    auto token = detail::make_wrapped_token<add_one_impl>(detail::make_wrapped_token<deferring_impl>(handler));
+
+    using inner = detail::wrapped_token<deferring_impl, decltype(handler)>;
+    static_assert(std::is_same_v<decltype(token), detail::wrapped_token<add_one_impl, inner>>);
+
+    ::MCPP_ASIO_NAMESPACE::async_result<decltype(token), void(int)>::initiate(
+        [](auto wrapped_handler) { std::move(wrapped_handler)(41); }, std::move(token));
+    REQUIRE(result == 42);
+}
+
+TEST_CASE("async_op_utils.fused_stages_forward_associators") {
+    auto ioc = ::MCPP_ASIO_NAMESPACE::io_context();
+    auto result = 0;
+    auto handler = ::MCPP_ASIO_NAMESPACE::bind_executor(ioc.get_executor(), [&](int i) { result = i; });
+    auto token = detail::make_wrapped_token<add_one_impl>(detail::make_wrapped_token<executor_probe_impl>(handler));
+
+    ::MCPP_ASIO_NAMESPACE::async_result<decltype(token), void(int)>::initiate(
+        [](auto wrapped_handler) { std::move(wrapped_handler)(41); }, std::move(token));
+    REQUIRE(result == 42);
+}
+
+TEST_CASE("async_op_utils.work_guard_around_transform_system_error") {
+    using ::MCPP_ASIO_NAMESPACE::experimental::use_promise;
+    auto ioc = ::MCPP_ASIO_NAMESPACE::io_context();
+    auto token = with_work_guard(transform_system_error(use_promise), ioc.get_executor());
+
+    using fused = detail::fused_impl<detail::with_work_guard_impl<decltype(ioc.get_executor())>,
+                                     detail::transform_system_error_impl>;
+    static_assert(std::is_same_v<decltype(token), detail::wrapped_token<fused, std::decay_t<decltype(use_promise)>>>);
+
+    auto promise = ::MCPP_ASIO_NAMESPACE::async_initiate<decltype(token), void(std::exception_ptr, int)>(
+        [&](auto handler) {
+            // A single layer around the promise handler
+            static_assert(is_wrapped_handler<decltype(handler)>::value);
+            static_assert(!is_wrapped_handler<decltype(handler.inner_handler_)>::value);
+
+            // The work guard lives in the handler
+            ioc.poll();
+            REQUIRE(!ioc.stopped());
+            std::move(handler)(std::exception_ptr(), 42);
+        },
+        token);
+
+    // and is released together with it
+    ioc.poll();
+    REQUIRE(ioc.stopped());
+}
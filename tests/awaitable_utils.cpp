@@ -16,6 +16,7 @@
 #include <exception>
 #include <iostream>
 #include <system_error>
+#include <vector>
 
 using namespace ::MCPP_ASIO_NAMESPACE;
 using namespace mcpp::asio;
@@ -37,6 +38,11 @@ auto throw_after(std::chrono::milliseconds duration) -> awaitable<void> {
     std::cerr << "THROWING" << std::endl;
     throw std::runtime_error("throw_after");
 }
+
+auto fail_after(std::chrono::milliseconds duration) -> awaitable<int> {
+    co_await throw_after(duration);
+    co_return 0;
+}
 } // namespace
 
 TEST_CASE("race.success") {
@@ -141,3 +147,115 @@ TEST_CASE("all_settled.failure") {
         detached);
     ioc.run();
 }
+
+TEST_CASE("quorum.success") {
+    auto ioc = io_context();
+    co_spawn(
+        ioc,
+        [&]() -> awaitable<void> {
+            try {
+                auto result = co_await quorum(2, sleep_for(1ms), throw_after(2ms), sleep_for(5ms), sleep_for(100ms));
+                REQUIRE(result.size() == 2);
+                REQUIRE(result[0].first == 0);
+                REQUIRE(result[1].first == 2);
+                REQUIRE(std::get<0>(result[0].second) == 0);
+            } catch (...) {
+                REQUIRE(false);
+            }
+        },
+        detached);
+    auto start = std::chrono::steady_clock::now();
+    ioc.run();
+    REQUIRE(std::chrono::steady_clock::now() - start < 100ms);
+}
+
+TEST_CASE("quorum.failure") {
+    auto ioc = io_context();
+    co_spawn(
+        ioc,
+        [&]() -> awaitable<void> {
+            try {
+                // With k = 2 of 4, the third failure decides the quorum
+                co_await quorum(2, throw_after(1ms), throw_after(2ms), sleep_for(100ms), throw_after(3ms));
+                REQUIRE(false);
+            } catch (std::runtime_error &e) {
+                REQUIRE(e.what() == "throw_after"sv);
+            } catch (...) {
+                REQUIRE(false);
+            }
+        },
+        detached);
+    auto start = std::chrono::steady_clock::now();
+    ioc.run();
+    REQUIRE(std::chrono::steady_clock::now() - start < 100ms);
+}
+
+TEST_CASE("quorum.range") {
+    auto ioc = io_context();
+    co_spawn(
+        ioc,
+        [&]() -> awaitable<void> {
+            try {
+                auto awaitables = std::vector<awaitable<int>>();
+                awaitables.push_back(sleep_for(100ms));
+                awaitables.push_back(sleep_for(1ms));
+                awaitables.push_back(sleep_for(5ms));
+                auto result = co_await quorum(2, std::move(awaitables));
+                REQUIRE(result.size() == 2);
+                REQUIRE(result[0].first == 1);
+                REQUIRE(result[1].first == 2);
+            } catch (...) {
+                REQUIRE(false);
+            }
+        },
+        detached);
+    auto start = std::chrono::steady_clock::now();
+    ioc.run();
+    REQUIRE(std::chrono::steady_clock::now() - start < 100ms);
+}
+
+TEST_CASE("quorum.range_failure") {
+    auto ioc = io_context();
+    co_spawn(
+        ioc,
+        [&]() -> awaitable<void> {
+            try {
+                auto awaitables = std::vector<awaitable<int>>();
+                awaitables.push_back(fail_after(1ms));
+                awaitables.push_back(sleep_for(100ms));
+                awaitables.push_back(fail_after(2ms));
+                co_await quorum(2, std::move(awaitables));
+                REQUIRE(false);
+            } catch (std::runtime_error &e) {
+                REQUIRE(e.what() == "throw_after"sv);
+            } catch (...) {
+                REQUIRE(false);
+            }
+        },
+        detached);
+    auto start = std::chrono::steady_clock::now();
+    ioc.run();
+    REQUIRE(std::chrono::steady_clock::now() - start < 100ms);
+}
+
+TEST_CASE("quorum.range_cancellation") {
+    auto ioc = io_context();
+    co_spawn(
+        ioc,
+        [&]() -> awaitable<void> {
+            try {
+                auto awaitables = std::vector<awaitable<int>>();
+                awaitables.push_back(sleep_for(100ms));
+                awaitables.push_back(sleep_for(100ms));
+                awaitables.push_back(sleep_for(100ms));
+                auto result = co_await race(quorum(2, std::move(awaitables)), sleep_for(1ms));
+                REQUIRE(result.index() == 1);
+            } catch (...) {
+                REQUIRE(false);
+            }
+        },
+        detached);
+    auto start = std::chrono::steady_clock::now();
+    ioc.run();
+    REQUIRE(std::chrono::steady_clock::now() - start < 100ms);
+}
@@ -0,0 +1,198 @@
+#include <mcpp/asio/buffer_pool.hpp>
+
+#include <asio/bind_cancellation_slot.hpp>
+#include <asio/cancellation_signal.hpp>
+#include <asio/io_context.hpp>
+#include <asio/post.hpp>
+
+#include <doctest/doctest.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <optional>
+#include <thread>
+#include <utility>
+
+using namespace ::MCPP_ASIO_NAMESPACE;
+using namespace mcpp::asio;
+
+TEST_CASE("buffer_pool.try_acquire") {
+    auto ioc = io_context();
+    auto pool = buffer_pool(ioc.get_executor(), 100, 2);
+    auto page_size = detail::system_page_size();
+    REQUIRE(pool.slab_size() == page_size);
+
+    auto first = pool.try_acquire();
+    auto second = pool.try_acquire();
+    REQUIRE(first);
+    REQUIRE(second);
+    REQUIRE(!pool.try_acquire());
+    REQUIRE(first.size() == page_size);
+    REQUIRE(reinterpret_cast<std::uintptr_t>(first.data().data()) % page_size == 0);
+    REQUIRE(first.data().data() != second.data().data());
+
+    first.reset();
+    auto stats = pool.stats();
+    REQUIRE(stats.in_use == 1);
+    REQUIRE(stats.high_water_mark == 2);
+    REQUIRE(stats.capacity == 2);
+    REQUIRE(pool.try_acquire());
+}
+
+TEST_CASE("buffer_pool.async_acquire_waits_for_release") {
+    auto ioc = io_context();
+    auto pool = buffer_pool(ioc.get_executor(), 4096, 1);
+    auto held = pool.try_acquire();
+    REQUIRE(held);
+
+    auto result = std::optional<std::pair<error_code, pooled_buffer>>();
+    pool.async_acquire([&](error_code ec, pooled_buffer buffer) { result.emplace(ec, std::move(buffer)); });
+    ioc.poll();
+    REQUIRE(!result);
+    REQUIRE(pool.stats().waiting == 1);
+
+    post(ioc, [&] { held.reset(); });
+    ioc.run();
+    REQUIRE(result);
+    REQUIRE(!result->first);
+    REQUIRE(result->second);
+    REQUIRE(pool.stats().waiting == 0);
+}
+
+TEST_CASE("buffer_pool.async_acquire_cancellation") {
+    auto ioc = io_context();
+    auto pool = buffer_pool(ioc.get_executor(), 4096, 1);
+    auto held = pool.try_acquire();
+
+    auto signal = cancellation_signal();
+    auto result = std::optional<error_code>();
+    pool.async_acquire(bind_cancellation_slot(signal.slot(), [&](error_code ec, pooled_buffer buffer) {
+        REQUIRE(!buffer);
+        result = ec;
+    }));
+    signal.emit(cancellation_type::terminal);
+    ioc.run();
+    REQUIRE(result == error::operation_aborted);
+    REQUIRE(pool.stats().waiting == 0);
+}
+
+TEST_CASE("buffer_pool.with_buffer_releases_with_handler") {
+    auto ioc = io_context();
+    auto pool = buffer_pool(ioc.get_executor(), 4096, 1);
+    auto buffer = pool.try_acquire();
+    auto *data = buffer.data().data();
+
+    auto called = false;
+    post(ioc, with_buffer([&] { called = true; }, std::move(buffer)));
+    REQUIRE(pool.stats().in_use == 1);
+    ioc.run();
+    REQUIRE(called);
+    REQUIRE(pool.stats().in_use == 0);
+    REQUIRE(pool.try_acquire().data().data() == data);
+}
+
+TEST_CASE("buffer_pool.slab_cached_by_other_thread") {
+    auto ioc = io_context();
+    auto pool = buffer_pool(ioc.get_executor(), 4096, 1);
+    auto released = std::promise<bool>();
+    auto done = std::promise<void>();
+
+    // The worker releases the only slab into its thread cache and stays alive, so the cache is not flushed
+    auto worker = std::thread([&] {
+        auto acquired = static_cast<bool>(pool.try_acquire());
+        released.set_value(acquired);
+        done.get_future().wait();
+    });
+    REQUIRE(released.get_future().get());
+    REQUIRE(pool.stats().in_use == 0);
+
+    auto result = std::optional<std::pair<error_code, pooled_buffer>>();
+    pool.async_acquire([&](error_code ec, pooled_buffer buffer) { result.emplace(ec, std::move(buffer)); });
+    ioc.run();
+    REQUIRE(result);
+    REQUIRE(!result->first);
+    REQUIRE(result->second);
+
+    result.reset();
+    REQUIRE(pool.try_acquire());
+
+    done.set_value();
+    worker.join();
+}
+
+TEST_CASE("buffer_pool.release_on_other_thread_wakes_waiter") {
+    auto ioc = io_context();
+    auto pool = buffer_pool(ioc.get_executor(), 4096, 1);
+    auto held = pool.try_acquire();
+
+    auto result = std::optional<std::pair<error_code, pooled_buffer>>();
+    pool.async_acquire([&](error_code ec, pooled_buffer buffer) { result.emplace(ec, std::move(buffer)); });
+
+    auto done = std::promise<void>();
+    auto worker = std::thread([&] {
+        held.reset();
+        done.get_future().wait();
+    });
+    ioc.run();
+    REQUIRE(result);
+    REQUIRE(!result->first);
+    REQUIRE(result->second);
+
+    done.set_value();
+    worker.join();
+}
+
+TEST_CASE("buffer_pool.pending_acquire_keeps_executor_busy") {
+    auto ioc = io_context();
+    auto pool = buffer_pool(ioc.get_executor(), 4096, 1);
+    auto held = pool.try_acquire();
+
+    auto acquired = std::atomic<bool>(false);
+    pool.async_acquire([&](error_code ec, pooled_buffer buffer) { acquired = !ec && buffer; });
+
+    auto stopped = std::atomic<bool>(false);
+    auto runner = std::thread([&] {
+        ioc.run();
+        stopped = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    REQUIRE(!stopped);
+
+    held.reset();
+    runner.join();
+    REQUIRE(acquired);
+}
+
+TEST_CASE("buffer_pool.two_pools_on_one_thread") {
+    auto ioc = io_context();
+    auto first = buffer_pool(ioc.get_executor(), 4096, 2);
+    auto second = buffer_pool(ioc.get_executor(), 4096, 2);
+
+    // The thread cache stays with the first pool instead of being flushed and rebound on every switch
+    auto *cached = static_cast<void *>(nullptr);
+    for (auto i = 0; i < 10; ++i) {
+        auto a = first.try_acquire();
+        auto b = second.try_acquire();
+        REQUIRE(a);
+        REQUIRE(b);
+        if (cached != nullptr) {
+            REQUIRE(a.data().data() == cached);
+        }
+        cached = a.data().data();
+        b.reset();
+        REQUIRE(second.stats().cached == 0);
+        a.reset();
+        REQUIRE(first.stats().cached == 1);
+    }
+
+    auto result = std::optional<error_code>();
+    first.async_acquire([&](error_code ec, pooled_buffer buffer) {
+        REQUIRE(buffer.data().data() == cached);
+        result = ec;
+    });
+    REQUIRE(first.stats().cached == 0);
+    ioc.run();
+    REQUIRE(result == error_code());
+}
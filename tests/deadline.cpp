@@ -0,0 +1,166 @@
+#if defined(__clang__) && !defined(ASIO_HAS_CO_AWAIT)
+#define ASIO_HAS_CO_AWAIT 1
+#endif
+
+#include <mcpp/asio/deadline.hpp>
+
+#include <asio/detached.hpp>
+#include <asio/error.hpp>
+#include <asio/io_context.hpp>
+#include <asio/steady_timer.hpp>
+
+#include <doctest/doctest.h>
+
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <system_error>
+
+using namespace ::MCPP_ASIO_NAMESPACE;
+using namespace mcpp::asio;
+using namespace std::literals;
+
+namespace {
+auto sleep_for(std::chrono::milliseconds duration) -> awaitable<void> {
+    auto timer = steady_timer(co_await this_coro::executor);
+    timer.expires_from_now(duration);
+    co_await timer.async_wait(use_awaitable);
+}
+} // namespace
+
+TEST_CASE("deadline.none_by_default") {
+    auto ioc = io_context();
+    co_spawn(
+        ioc,
+        [&]() -> awaitable<void> {
+            auto deadline = co_await current_deadline();
+            auto remaining = co_await remaining_budget();
+            REQUIRE(!deadline);
+            REQUIRE(remaining == deadline_clock::duration::max());
+        },
+        detached);
+    ioc.run();
+}
+
+TEST_CASE("deadline.visible_inside") {
+    auto ioc = io_context();
+    auto deadline = deadline_clock::now() + 1s;
+    co_spawn(
+        ioc,
+        [&]() -> awaitable<void> {
+            auto seen = co_await with_deadline(deadline, current_deadline());
+            REQUIRE(seen == deadline);
+            auto remaining = co_await with_deadline(deadline, remaining_budget());
+            REQUIRE(remaining > 0ms);
+            REQUIRE(remaining <= 1s);
+        },
+        detached);
+    ioc.run();
+}
+
+TEST_CASE("deadline.expires") {
+    auto ioc = io_context();
+    auto timed_out = false;
+    co_spawn(
+        ioc,
+        [&]() -> awaitable<void> {
+            try {
+                co_await with_timeout(5ms, sleep_for(1s));
+            } catch (const std::system_error &e) {
+                timed_out = e.code() == error::timed_out;
+            }
+        },
+        detached);
+    auto start = deadline_clock::now();
+    ioc.run();
+    REQUIRE(timed_out);
+    REQUIRE(deadline_clock::now() - start < 1s);
+}
+
+TEST_CASE("deadline.inherited_by_combinators") {
+    auto ioc = io_context();
+    auto deadline = deadline_clock::now() + 1s;
+    co_spawn(
+        ioc,
+        [&]() -> awaitable<void> {
+            auto [first, second] = co_await with_deadline(deadline, all(current_deadline(), current_deadline()));
+            REQUIRE(first == deadline);
+            REQUIRE(second == deadline);
+            auto raced = co_await with_deadline(deadline, race(current_deadline(), sleep_for(1s)));
+            REQUIRE(raced.index() == 0);
+            REQUIRE(std::get<0>(raced) == deadline);
+        },
+        detached);
+    ioc.run();
+}
+
+TEST_CASE("deadline.nested_uses_earliest") {
+    auto ioc = io_context();
+    auto outer = deadline_clock::now() + 1s;
+    co_spawn(
+        ioc,
+        [&]() -> awaitable<void> {
+            auto later = co_await with_deadline(outer, with_deadline(outer + 1s, current_deadline()));
+            REQUIRE(later == outer);
+            auto earlier = co_await with_deadline(outer, with_deadline(outer - 100ms, current_deadline()));
+            REQUIRE(earlier == outer - 100ms);
+        },
+        detached);
+    ioc.run();
+}
+
+TEST_CASE("deadline.cancels_nested_children") {
+    auto ioc = io_context();
+    auto timed_out = false;
+    co_spawn(
+        ioc,
+        [&]() -> awaitable<void> {
+            try {
+                co_await with_timeout(5ms, all(sleep_for(1s), race(sleep_for(1s), sleep_for(2s))));
+            } catch (const std::system_error &e) {
+                timed_out = e.code() == error::timed_out;
+            }
+        },
+        detached);
+    auto start = deadline_clock::now();
+    ioc.run();
+    REQUIRE(timed_out);
+    REQUIRE(deadline_clock::now() - start < 1s);
+}
+
+TEST_CASE("deadline.outer_cancellation_is_not_a_timeout") {
+    auto ioc = io_context();
+    auto observed = std::optional<std::error_code>();
+    co_spawn(
+        ioc,
+        [&]() -> awaitable<void> {
+            auto guarded = [&]() -> awaitable<void> {
+                try {
+                    co_await with_timeout(1s, sleep_for(1s));
+                } catch (const std::system_error &e) {
+                    observed = e.code();
+                    throw;
+                }
+            };
+            auto result = co_await race(guarded(), sleep_for(5ms));
+            REQUIRE(result.index() == 1);
+        },
+        detached);
+    auto start = deadline_clock::now();
+    ioc.run();
+    REQUIRE(observed == error::operation_aborted);
+    REQUIRE(deadline_clock::now() - start < 1s);
+}
+
+TEST_CASE("deadline.executor_fits_small_object_buffer") {
+    // any_io_executor stores targets of up to a shared_ptr and a pointer inline
+    static_assert(sizeof(deadline_executor) <= sizeof(std::shared_ptr<void>) + sizeof(void *));
+
+    auto ioc = io_context();
+    auto deadline = deadline_clock::now() + 1s;
+    auto executor = any_io_executor(deadline_executor(ioc.get_executor(), deadline));
+    REQUIRE(get_deadline(executor) == deadline);
+    auto copy = executor;
+    REQUIRE(copy == executor);
+    REQUIRE(get_deadline(prefer(copy, execution::outstanding_work.tracked)) == deadline);
+}
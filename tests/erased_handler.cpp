@@ -0,0 +1,189 @@
+#include <mcpp/asio/erased_handler.hpp>
+#include <mcpp/asio/transform_system_error.hpp>
+#include <mcpp/asio/with_work_guard.hpp>
+
+#include <asio/async_result.hpp>
+#include <asio/bind_allocator.hpp>
+#include <asio/bind_cancellation_slot.hpp>
+#include <asio/bind_executor.hpp>
+#include <asio/experimental/promise.hpp>
+#include <asio/io_context.hpp>
+#include <asio/post.hpp>
+#include <asio/strand.hpp>
+
+#include <doctest/doctest.h>
+
+#include <array>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+using namespace ::MCPP_ASIO_NAMESPACE;
+using namespace mcpp::asio;
+
+namespace {
+// Stateful allocator that counts its allocations
+template <typename T>
+struct counting_allocator {
+    using value_type = T;
+
+    int *count;
+
+    explicit counting_allocator(int *count) noexcept : count(count) {}
+
+    template <typename U>
+    // NOLINTNEXTLINE(hicpp-explicit-conversions)
+    counting_allocator(const counting_allocator<U> &other) noexcept : count(other.count) {}
+
+    auto allocate(std::size_t n) -> T * {
+        ++*count;
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T *ptr, std::size_t n) { std::allocator<T>().deallocate(ptr, n); }
+
+    template <typename U>
+    auto operator==(const counting_allocator<U> &other) const noexcept -> bool {
+        return count == other.count;
+    }
+};
+
+// Allocator that shares ownership of its state, like a typical arena allocator, so it is not trivially copyable
+template <typename T>
+struct shared_counting_allocator {
+    using value_type = T;
+
+    std::shared_ptr<int> count;
+
+    explicit shared_counting_allocator(std::shared_ptr<int> count) noexcept : count(std::move(count)) {}
+
+    template <typename U>
+    // NOLINTNEXTLINE(hicpp-explicit-conversions)
+    shared_counting_allocator(const shared_counting_allocator<U> &other) noexcept : count(other.count) {}
+
+    auto allocate(std::size_t n) -> T * {
+        ++*count;
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T *ptr, std::size_t n) { std::allocator<T>().deallocate(ptr, n); }
+
+    template <typename U>
+    auto operator==(const shared_counting_allocator<U> &other) const noexcept -> bool {
+        return count == other.count;
+    }
+};
+} // namespace
+
+TEST_CASE("erased_handler.small_handler_is_stored_inline") {
+    auto result = 0;
+    auto handler =
+        erased_handler<void(int)>([&result, p = std::make_unique<int>(1)](int i) { result = i + *p; });
+    REQUIRE(handler.stored_inline());
+    auto moved = std::move(handler);
+    REQUIRE(!handler);
+    std::move(moved)(41);
+    REQUIRE(result == 42);
+    REQUIRE(!moved);
+}
+
+TEST_CASE("erased_handler.large_handler_is_allocated") {
+    auto result = size_t{0};
+    auto large = std::array<char, 2 * default_erased_handler_buffer_size>{};
+    auto handler = erased_handler<void()>([&result, large] { result = large.size(); });
+    REQUIRE(!handler.stored_inline());
+    std::move(handler)();
+    REQUIRE(result == large.size());
+}
+
+TEST_CASE("erased_handler.forwards_associated_executor") {
+    auto ioc = io_context();
+    auto strand = make_strand(ioc);
+    auto ran_in_strand = false;
+    auto handler = erased_handler<void()>(
+        bind_executor(strand, [&] { ran_in_strand = strand.running_in_this_thread(); }));
+    REQUIRE(get_associated_executor(handler, ioc.get_executor()) == any_io_executor(strand));
+    post(ioc, std::move(handler));
+    ioc.run();
+    REQUIRE(ran_in_strand);
+}
+
+TEST_CASE("erased_handler.forwards_associated_cancellation_slot") {
+    auto signal = cancellation_signal();
+    auto handler = erased_handler<void()>(bind_cancellation_slot(signal.slot(), [] {}));
+    REQUIRE(get_associated_cancellation_slot(handler) == signal.slot());
+}
+
+TEST_CASE("erased_handler.forwards_associated_allocator") {
+    auto count = 0;
+    auto called = false;
+    auto handler = erased_handler<void()>(bind_allocator(counting_allocator<void>(&count), [&] { called = true; }));
+    REQUIRE(handler.stored_inline());
+
+    // Operations that store the erased handler allocate through the handler's allocator
+    auto ioc = io_context();
+    post(ioc, std::move(handler));
+    REQUIRE(count > 0);
+    ioc.run();
+    REQUIRE(called);
+
+    // Handlers that do not fit inline are allocated with it as well
+    count = 0;
+    auto large = std::array<char, 2 * default_erased_handler_buffer_size>{};
+    auto large_handler = erased_handler<void()>(bind_allocator(counting_allocator<void>(&count), [large] {}));
+    REQUIRE(!large_handler.stored_inline());
+    REQUIRE(count == 1);
+}
+
+TEST_CASE("erased_handler.forwards_non_trivial_allocator") {
+    static_assert(!std::is_trivially_copyable_v<shared_counting_allocator<void>>);
+    auto count = std::make_shared<int>(0);
+    auto called = false;
+    auto handler =
+        erased_handler<void()>(bind_allocator(shared_counting_allocator<void>(count), [&] { called = true; }));
+    REQUIRE(handler.stored_inline());
+
+    auto allocator = get_associated_allocator(handler);
+    REQUIRE(allocator != detail::erased_allocator<void>());
+    auto copy = allocator;
+    REQUIRE(copy == allocator);
+
+    auto ioc = io_context();
+    post(ioc, std::move(handler));
+    REQUIRE(*count > 0);
+    ioc.run();
+    REQUIRE(called);
+
+    // The erased copies share the allocator state and release it when they go away
+    REQUIRE(count.use_count() == 3);
+    allocator = detail::erased_allocator<void>();
+    copy = detail::erased_allocator<void>();
+    REQUIRE(count.use_count() == 1);
+
+    auto large = std::array<char, 2 * default_erased_handler_buffer_size>{};
+    *count = 0;
+    auto large_handler = erased_handler<void()>(bind_allocator(shared_counting_allocator<void>(count), [large] {}));
+    REQUIRE(!large_handler.stored_inline());
+    REQUIRE(*count == 1);
+}
+
+TEST_CASE("erased_handler.default_allocator_is_not_kept") {
+    // Without a custom allocator, allocations go through asio's recycling allocator
+    auto handler = erased_handler<void()>([] {});
+    REQUIRE(get_associated_allocator(handler) == detail::erased_allocator<void>());
+}
+
+TEST_CASE("erased_handler.fused_promise_handler_is_stored_inline") {
+    auto ioc = io_context();
+    auto token = with_work_guard(transform_system_error(experimental::use_promise), ioc.get_executor());
+    auto promise = async_initiate<decltype(token), void(std::exception_ptr, int)>(
+        [](auto handler) {
+            static_assert(detail::fits_inline<decltype(handler), default_erased_handler_buffer_size>);
+            auto erased = erased_handler<void(std::exception_ptr, int)>(std::move(handler));
+            REQUIRE(erased.stored_inline());
+            std::move(erased)(std::exception_ptr(), 42);
+        },
+        token);
+}
@@ -0,0 +1,71 @@
+#include <mcpp/asio/tracing.hpp>
+
+#include <doctest/doctest.h>
+
+#include <atomic>
+#include <sstream>
+#include <string>
+#include <thread>
+
+using namespace mcpp::asio;
+
+TEST_CASE("tracing.spans_are_linked_to_parent") {
+    tracing::clear();
+    auto parent = tracing::begin_span("parent");
+    {
+        auto scope = tracing::current_span_scope(parent);
+        auto child = tracing::scoped_span("child");
+        REQUIRE(child.id() != parent);
+    }
+    tracing::end_span(parent, "parent");
+    REQUIRE(tracing::current() == 0);
+
+    auto os = std::ostringstream();
+    tracing::write_chrome_trace(os);
+    auto trace = os.str();
+    REQUIRE(trace.find(R"("name":"parent","cat":"mcpp.asio","ph":"b","id":)" + std::to_string(parent)) !=
+            std::string::npos);
+    REQUIRE(trace.find(R"("args":{"parent":)" + std::to_string(parent) + "}") != std::string::npos);
+    REQUIRE(trace.find(R"("ph":"e","id":)" + std::to_string(parent)) != std::string::npos);
+}
+
+TEST_CASE("tracing.records_from_other_threads_are_written") {
+    tracing::clear();
+    std::thread([] { tracing::scoped_span("worker", 0, 3); }).join();
+
+    auto os = std::ostringstream();
+    tracing::write_chrome_trace(os);
+    auto trace = os.str();
+    REQUIRE(trace.find(R"("name":"worker")") != std::string::npos);
+    REQUIRE(trace.find(R"("child":3)") != std::string::npos);
+}
+
+TEST_CASE("tracing.clear") {
+    tracing::scoped_span("discarded");
+    tracing::clear();
+
+    auto os = std::ostringstream();
+    tracing::write_chrome_trace(os);
+    REQUIRE(os.str().find("discarded") == std::string::npos);
+}
+
+TEST_CASE("tracing.clear_while_recording") {
+    auto stop = std::atomic<bool>(false);
+    auto worker = std::thread([&] {
+        while (!stop) {
+            tracing::scoped_span("busy", 0);
+        }
+    });
+    for (auto i = 0; i < 100; ++i) {
+        tracing::clear();
+    }
+    stop = true;
+    worker.join();
+
+    tracing::clear();
+    REQUIRE(tracing::snapshot().empty());
+    tracing::scoped_span("after", 0);
+    auto records = tracing::snapshot();
+    REQUIRE(records.size() == 2);
+    REQUIRE(std::string(records.front().name) == "after");
+}
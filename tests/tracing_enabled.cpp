@@ -0,0 +1,99 @@
+#if defined(__clang__) && !defined(ASIO_HAS_CO_AWAIT)
+#define ASIO_HAS_CO_AWAIT 1
+#endif
+
+// Built as a separate test executable with MCPP_ASIO_ENABLE_TRACING=1
+#include <mcpp/asio/awaitable_utils.hpp>
+#include <mcpp/asio/tracing.hpp>
+#include <mcpp/asio/with_work_guard.hpp>
+
+#include <asio/detached.hpp>
+#include <asio/io_context.hpp>
+#include <asio/post.hpp>
+
+#include <doctest/doctest.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <string_view>
+#include <vector>
+
+static_assert(MCPP_ASIO_ENABLE_TRACING);
+
+using namespace ::MCPP_ASIO_NAMESPACE;
+using namespace mcpp::asio;
+
+namespace {
+auto begins(std::string_view name) -> std::vector<tracing::record> {
+    auto records = tracing::snapshot();
+    auto result = std::vector<tracing::record>();
+    std::copy_if(records.begin(), records.end(), std::back_inserter(result), [&](const tracing::record &rec) {
+        return rec.ph == tracing::phase::begin && rec.name == name;
+    });
+    return result;
+}
+
+auto count_ends(tracing::span_id id) -> std::size_t {
+    auto records = tracing::snapshot();
+    return std::count_if(records.begin(), records.end(),
+                         [&](const tracing::record &rec) { return rec.ph == tracing::phase::end && rec.id == id; });
+}
+
+auto value(int i) -> awaitable<int> {
+    co_return i;
+}
+} // namespace
+
+TEST_CASE("tracing_enabled.wrapped_token") {
+    tracing::clear();
+    auto ioc = io_context();
+    auto current_in_handler = tracing::span_id{0};
+    post(ioc, with_work_guard([&] { current_in_handler = tracing::current(); }, ioc.get_executor()));
+    ioc.run();
+
+    auto spans = begins("with_work_guard");
+    REQUIRE(spans.size() == 1);
+    REQUIRE(current_in_handler == spans[0].id);
+    REQUIRE(count_ends(spans[0].id) == 1);
+}
+
+TEST_CASE("tracing_enabled.abandoned_handler_ends_span") {
+    tracing::clear();
+    {
+        auto ioc = io_context();
+        post(ioc, with_work_guard([] {}, ioc.get_executor()));
+    }
+
+    auto spans = begins("with_work_guard");
+    REQUIRE(spans.size() == 1);
+    REQUIRE(count_ends(spans[0].id) == 1);
+}
+
+TEST_CASE("tracing_enabled.combinator_children") {
+    tracing::clear();
+    auto ioc = io_context();
+    co_spawn(
+        ioc,
+        []() -> awaitable<void> {
+            co_await all(value(1), value(2));
+            co_await race(value(1), value(2));
+        },
+        detached);
+    ioc.run();
+
+    for (auto name : {std::string_view("all"), std::string_view("race")}) {
+        auto spans = begins(name);
+        REQUIRE(spans.size() == 3);
+        auto parent = std::find_if(spans.begin(), spans.end(), [](const auto &rec) { return rec.child_index < 0; });
+        REQUIRE(parent != spans.end());
+        for (auto index = 0; index < 2; ++index) {
+            auto child = std::find_if(spans.begin(), spans.end(),
+                                      [&](const auto &rec) { return rec.child_index == index; });
+            REQUIRE(child != spans.end());
+            REQUIRE(child->parent == parent->id);
+            REQUIRE(count_ends(child->id) == 1);
+        }
+        REQUIRE(count_ends(parent->id) == 1);
+    }
+}